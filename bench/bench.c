@@ -0,0 +1,137 @@
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+double BenchNow(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+bool BenchParseArgs(BenchSuite *suite, int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (value == NULL) {
+            fprintf(stderr, "usage: %s [--json FILE] [--baseline FILE] [--threshold RATIO] [--seconds S] [--capacity N] [--threads N]\n", argv[0]);
+            return false;
+        }
+        if (strcmp(arg, "--json") == 0) {
+            suite->jsonPath = value;
+        } else if (strcmp(arg, "--baseline") == 0) {
+            suite->baselinePath = value;
+        } else if (strcmp(arg, "--threshold") == 0) {
+            suite->threshold = atof(value);
+        } else if (strcmp(arg, "--seconds") == 0) {
+            suite->seconds = atof(value);
+        } else if (strcmp(arg, "--capacity") == 0) {
+            suite->capacity = atoi(value);
+        } else if (strcmp(arg, "--threads") == 0) {
+            suite->threads = atoi(value);
+        } else {
+            fprintf(stderr, "unknown option %s\n", arg);
+            return false;
+        }
+        i++;
+    }
+    return suite->capacity > 0 && suite->seconds > 0;
+}
+
+void BenchReport(BenchSuite *suite, const char *name, double value, const char *unit, bool higherIsBetter) {
+    if (suite->resultCount == suite->resultCapacity) {
+        const int capacity = suite->resultCapacity > 0 ? suite->resultCapacity * 2 : 32;
+        BenchResult *results = realloc(suite->results, sizeof(BenchResult) * capacity);
+        if (results == NULL) {
+            fprintf(stderr, "out of memory for the result of %s\n", name);
+            suite->resultsLost = true;
+            return;
+        }
+        suite->results = results;
+        suite->resultCapacity = capacity;
+    }
+    BenchResult *result = &suite->results[suite->resultCount++];
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    snprintf(result->unit, sizeof(result->unit), "%s", unit);
+    result->value = value;
+    result->higherIsBetter = higherIsBetter;
+    printf("%-40s %16.2f %s\n", name, value, unit);
+}
+
+static bool WriteJson(const BenchSuite *suite) {
+    FILE *file = fopen(suite->jsonPath, "w");
+    if (file == NULL) {
+        fprintf(stderr, "can't write %s\n", suite->jsonPath);
+        return false;
+    }
+    // One benchmark per line, which is what ReadBaseline expects
+    fprintf(file, "{\n  \"suite\": \"%s\",\n  \"benchmarks\": [\n", suite->name);
+    for (int i = 0; i < suite->resultCount; i++) {
+        const BenchResult *result = &suite->results[i];
+        fprintf(file, "    {\"name\": \"%s\", \"value\": %.6f, \"unit\": \"%s\", \"higher_is_better\": %s}%s\n",
+            result->name, result->value, result->unit, result->higherIsBetter ? "true" : "false",
+            (i + 1 < suite->resultCount) ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+    return true;
+}
+
+// Looks up one benchmark value in a JSON file written by WriteJson
+static bool ReadBaseline(FILE *file, const char *name, double *value) {
+    char line[256];
+    char key[80];
+    snprintf(key, sizeof(key), "\"name\": \"%s\",", name);
+    rewind(file);
+    while (fgets(line, sizeof(line), file)) {
+        if (strstr(line, key) == NULL) continue;
+        const char *field = strstr(line, "\"value\": ");
+        if (field == NULL) return false;
+        *value = atof(field + strlen("\"value\": "));
+        return true;
+    }
+    return false;
+}
+
+// 1 when a result got worse than the baseline by more than the threshold
+static int CheckBaseline(const BenchSuite *suite) {
+    FILE *file = fopen(suite->baselinePath, "r");
+    if (file == NULL) {
+        // No baseline yet is not a regression, the first run produces one
+        printf("no baseline at %s, skipping regression check\n", suite->baselinePath);
+        return 0;
+    }
+    int status = 0;
+    for (int i = 0; i < suite->resultCount; i++) {
+        const BenchResult *result = &suite->results[i];
+        double baseline = 0;
+        if (!ReadBaseline(file, result->name, &baseline) || baseline <= 0) continue;
+        const double change = result->higherIsBetter ?
+            (baseline - result->value) / baseline :
+            (result->value - baseline) / baseline;
+        if (change > suite->threshold) {
+            printf("REGRESSION %s: %.2f %s vs baseline %.2f (%.1f%% worse, threshold %.1f%%)\n",
+                result->name, result->value, result->unit, baseline, change * 100, suite->threshold * 100);
+            status = 1;
+        }
+    }
+    fclose(file);
+    return status;
+}
+
+int BenchFinish(BenchSuite *suite) {
+    int status = suite->resultsLost ? 1 : 0;
+    if (suite->jsonPath != NULL && !WriteJson(suite)) {
+        status = 1;
+    }
+    if (suite->baselinePath != NULL && CheckBaseline(suite) != 0) {
+        status = 1;
+    }
+    free(suite->results);
+    suite->results = NULL;
+    suite->resultCount = 0;
+    suite->resultCapacity = 0;
+    return status;
+}
@@ -0,0 +1,38 @@
+#ifndef PIXEL_BLOOM_BENCH_H
+#define PIXEL_BLOOM_BENCH_H
+
+// Tiny benchmark harness: collects named results, writes them as JSON and
+// compares them against a baseline JSON written by a previous run.
+
+#include <stdbool.h>
+
+typedef struct BenchResult {
+    char name[64];
+    char unit[16];
+    double value;
+    bool higherIsBetter;
+} BenchResult;
+
+typedef struct BenchSuite {
+    const char *name;
+    const char *jsonPath;      // --json, NULL to skip writing
+    const char *baselinePath;  // --baseline, NULL to skip the regression check
+    double threshold;          // --threshold, allowed relative slowdown (0.10 = 10%)
+    double seconds;            // --seconds, time budget per benchmark
+    int capacity;              // --capacity, particles per store
+    int threads;               // --threads, job system threads, 0 for every hardware thread
+    BenchResult *results;      // grows with every BenchReport, freed by BenchFinish
+    int resultCount;
+    int resultCapacity;
+    bool resultsLost;          // a result didn't fit in memory, BenchFinish fails the run
+} BenchSuite;
+
+double BenchNow(void);
+// Parses the common options, returns false (after printing usage) on bad input
+bool BenchParseArgs(BenchSuite *suite, int argc, char **argv);
+void BenchReport(BenchSuite *suite, const char *name, double value, const char *unit, bool higherIsBetter);
+// Writes the JSON and checks the baseline, returns the process exit code.
+// Frees the results
+int BenchFinish(BenchSuite *suite);
+
+#endif // PIXEL_BLOOM_BENCH_H
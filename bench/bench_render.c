@@ -0,0 +1,123 @@
+// Frame time of the native 160x90 target render plus the upscale to the
+// window, with batched particles, with the DrawPixelV fallback and with the
+// software renderer's one upload. Needs a GL context, exits with BENCH_SKIPPED when there is none.
+
+#include "bench.h"
+#include "render.h"
+#include "soft_render.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_SKIPPED 77
+
+static void BenchFrames(BenchSuite *suite, RenderTexture2D target, const Game *game,
+    GameTextures *textures, ParticleRenderMode mode, const char *suffix) {
+    ParticleRenderer particles;
+    ParticleRendererInit(&particles, mode);
+
+    const Rectangle sourceRec = { 0.0f, 0.0f, target.texture.width, -target.texture.height };
+    const Rectangle destRec = { 0.0f, 0.0f, GetScreenWidth(), GetScreenHeight() };
+    double nativeTime = 0;
+    double frameTime = 0;
+    int frames = 0;
+    while (frameTime < suite->seconds || frames < 10) {
+        const double start = BenchNow();
+        DrawNativeFrame(target, game, textures, &particles, 0, true);
+        const double nativeEnd = BenchNow();
+        BeginDrawing();
+            ClearBackground(DARKGRAY);
+            DrawTexturePro(target.texture, sourceRec, destRec, (Vector2){0}, 0.0f, WHITE);
+        EndDrawing();
+        nativeTime += nativeEnd - start;
+        frameTime += BenchNow() - start;
+        frames++;
+    }
+    ParticleRendererFree(&particles);
+
+    char name[64];
+    snprintf(name, sizeof(name), "native_render%s_ms", suffix);
+    BenchReport(suite, name, nativeTime * 1000 / frames, "ms", false);
+    snprintf(name, sizeof(name), "frame%s_ms", suffix);
+    BenchReport(suite, name, frameTime * 1000 / frames, "ms", false);
+}
+
+// The CPU frame and its upload count as the native render, like the target render above
+static void BenchSoftFrames(BenchSuite *suite, const Game *game) {
+    SoftFrame *frame = calloc(1, sizeof(SoftFrame));
+    if (frame == NULL) return;
+    const Image image = {
+        .data = frame->pixels,
+        .width = NATIVE_WIDTH,
+        .height = NATIVE_HEIGHT,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+    };
+    const Texture2D texture = LoadTextureFromImage(image);
+    const Rectangle sourceRec = { 0.0f, 0.0f, NATIVE_WIDTH, NATIVE_HEIGHT };
+    const Rectangle destRec = { 0.0f, 0.0f, GetScreenWidth(), GetScreenHeight() };
+    double nativeTime = 0;
+    double frameTime = 0;
+    int frames = 0;
+    while (frameTime < suite->seconds || frames < 10) {
+        const double start = BenchNow();
+        SoftRenderFrame(frame, game, 0, true);
+        UpdateTexture(texture, frame->pixels);
+        const double nativeEnd = BenchNow();
+        BeginDrawing();
+            ClearBackground(DARKGRAY);
+            DrawTexturePro(texture, sourceRec, destRec, (Vector2){0}, 0.0f, WHITE);
+        EndDrawing();
+        nativeTime += nativeEnd - start;
+        frameTime += BenchNow() - start;
+        frames++;
+    }
+    UnloadTexture(texture);
+    free(frame);
+
+    BenchReport(suite, "native_render_soft_ms", nativeTime * 1000 / frames, "ms", false);
+    BenchReport(suite, "frame_soft_ms", frameTime * 1000 / frames, "ms", false);
+}
+
+int main(int argc, char **argv) {
+    BenchSuite suite = { .threshold = 0.10, .seconds = 0.5, .capacity = DEFAULT_WIND_CAPACITY };
+    if (!BenchParseArgs(&suite, argc, argv)) return 1;
+    char suiteName[32];
+    snprintf(suiteName, sizeof(suiteName), "render-%d", suite.capacity);
+    suite.name = suiteName;
+
+    SetTraceLogLevel(LOG_WARNING);
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(800, 450, "pixel-bloom-bench-render");
+    if (!IsWindowReady()) {
+        printf("no display, skipping %s\n", suite.name);
+        return BENCH_SKIPPED;
+    }
+
+    RenderTexture2D target = LoadRenderTexture(NATIVE_WIDTH, NATIVE_HEIGHT);
+    GameTextures textures = {0};
+    LoadGameTextures(&textures);
+
+    Game *game = calloc(1, sizeof(Game));
+    if (game == NULL || !SimInit(game, suite.capacity, suite.capacity)) return 1;
+    SimReset(game);
+    game->state = StateInGame;
+    game->isShielding = true;
+    game->shieldPosition = (Vector2){30, 60};
+    game->shields[0] = game->shieldPosition;
+    game->shieldCount = 1;
+    srand(1);
+    while (ParticleStorePush(&game->wind, 1 + rand() % FLOWER_LINE, NATIVE_HEIGHT - 30 + rand() % 20, 10 + rand() % 10)) {}
+
+    printf("%s (%d wind particles)\n", suite.name, suite.capacity);
+    BenchFrames(&suite, target, game, &textures, ParticleRenderAuto, "");
+    BenchFrames(&suite, target, game, &textures, ParticleRenderPixels, "_pixels");
+    BenchSoftFrames(&suite, game);
+
+    SimFree(game);
+    free(game);
+    UnloadGameTextures(&textures);
+    UnloadRenderTexture(target);
+    CloseWindow();
+    return BenchFinish(&suite);
+}
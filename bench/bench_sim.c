@@ -0,0 +1,274 @@
+// Tick benchmarks for the simulation core at the particle capacity given by
+// --capacity.
+
+#include "bench.h"
+#include "sim.h"
+#include "snapshot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Ticks run between two refills of the particle arrays
+#define BENCH_BATCH_TICKS 64
+// Small enough that no particle reaches the flower within a batch
+static const float BENCH_DELTA = 0.0001f;
+
+static JobSystem *jobs = NULL;
+
+static void FillWind(Game *game) {
+    game->wind.count = 0;
+    while (ParticleStorePush(&game->wind, 1 + rand() % (FLOWER_LINE - 10), NATIVE_HEIGHT - 30 + rand() % 20, 10 + rand() % 10)) {}
+    game->windParticleCD = 1e9f;
+}
+
+static void FillWater(Game *game) {
+    game->water.count = 0;
+    while (ParticleStorePush(&game->water, 60 + rand() % 20, rand() % (GROUND_LEVEL - 10), 1 + rand() % 10)) {}
+    game->waterParticleCD = 1e9f;
+}
+
+static Game *NewBenchGame(const BenchSuite *suite) {
+    Game *game = calloc(1, sizeof(Game));
+    if (game == NULL || !SimInit(game, suite->capacity, suite->capacity)) exit(1);
+    SimReset(game);
+    game->jobs = jobs;
+    game->state = StateInGame;
+    // The shield test runs for every particle but never removes any
+    game->isShielding = true;
+    game->shieldPosition = (Vector2){-100, -100};
+    game->shields[0] = game->shieldPosition;
+    game->shieldCount = 1;
+    return game;
+}
+
+// Spreads the shields over the wind band, where they actually catch particles
+static void PlaceShields(Game *game, int shieldCount) {
+    for (int i = 0; i < shieldCount; i++) {
+        game->shields[i] = (Vector2){ 8 + i * 8, NATIVE_HEIGHT - 25 + (i % 3) * 6 };
+    }
+    game->shieldCount = shieldCount;
+}
+
+static void BenchParticles(BenchSuite *suite, bool wind, int shieldCount) {
+    Game *game = NewBenchGame(suite);
+    if (shieldCount > 1) PlaceShields(game, shieldCount);
+    const ParticleStore *store = wind ? &game->wind : &game->water;
+    long long ticks = 0;
+    // Particles each tick started with, summed: shields take some out on the way
+    double particleTicks = 0;
+    double elapsed = 0;
+    while (elapsed < suite->seconds) {
+        if (wind) FillWind(game); else FillWater(game);
+        const double start = BenchNow();
+        for (int i = 0; i < BENCH_BATCH_TICKS; i++) {
+            particleTicks += store->count;
+            if (wind) UpdateWindParticles(game, BENCH_DELTA); else UpdateWaterParticles(game, BENCH_DELTA);
+        }
+        elapsed += BenchNow() - start;
+        ticks += BENCH_BATCH_TICKS;
+    }
+    char prefix[32];
+    char name[64];
+    if (shieldCount > 1) {
+        snprintf(prefix, sizeof(prefix), "%s_%d_shields", wind ? "wind" : "water", shieldCount);
+    } else {
+        snprintf(prefix, sizeof(prefix), "%s", wind ? "wind" : "water");
+    }
+    snprintf(name, sizeof(name), "%s_ticks_per_sec", prefix);
+    BenchReport(suite, name, ticks / elapsed, "ticks/s", true);
+    snprintf(name, sizeof(name), "%s_ns_per_particle", prefix);
+    BenchReport(suite, name, elapsed * 1e9 / particleTicks, "ns", false);
+    SimFree(game);
+    free(game);
+}
+
+static void BenchTakeDamage(BenchSuite *suite) {
+    Game *game = NewBenchGame(suite);
+    long long calls = 0;
+    double elapsed = 0;
+    while (elapsed < suite->seconds) {
+        game->flower.health = 1e9f;
+        const double start = BenchNow();
+        for (int i = 0; i < 100000; i++) {
+            TakeDamage(game, 1.0f, WindDamage);
+        }
+        elapsed += BenchNow() - start;
+        calls += 100000;
+    }
+    BenchReport(suite, "take_damage_ns_per_call", elapsed * 1e9 / calls, "ns", false);
+    SimFree(game);
+    free(game);
+}
+
+static void BenchTakeWater(BenchSuite *suite) {
+    Game *game = NewBenchGame(suite);
+    long long calls = 0;
+    double elapsed = 0;
+    while (elapsed < suite->seconds) {
+        game->flower.waterLevel = 0;
+        const double start = BenchNow();
+        for (int i = 0; i < 100000; i++) {
+            TakeWater(game, 0.001f);
+        }
+        elapsed += BenchNow() - start;
+        calls += 100000;
+    }
+    BenchReport(suite, "take_water_ns_per_call", elapsed * 1e9 / calls, "ns", false);
+    SimFree(game);
+    free(game);
+}
+
+// Brings every flower back between two batches, which are too short for wind
+// to kill one
+static void ReviveGarden(Game *game) {
+    for (int i = 0; i < game->garden.count; i++) {
+        game->garden.health[i] = 100;
+        game->garden.isAlive[i] = 1;
+    }
+    game->garden.aliveCount = game->garden.count;
+    game->state = StateInGame;
+}
+
+// Whole SimSteps of a garden whose stores hold the suite's capacity, every
+// flower alive and the weather changing every few seconds of sim time, so
+// both particle passes run at their steady state counts
+// With extra shields, each sits in the wind band of a plot of its own, spread
+// over the whole garden
+static void BenchGarden(BenchSuite *suite, int extraShields) {
+    const int flowers = suite->capacity / GARDEN_PARTICLES_PER_FLOWER;
+    if (flowers == 0) return;
+    Game *game = calloc(1, sizeof(Game));
+    if (game == NULL || !SimInitGarden(game, flowers)) exit(1);
+    SimSeed(game, 1);
+    SimReset(game);
+    game->jobs = jobs;
+    Input input = {0};
+    for (int i = 0; i < extraShields; i++) {
+        const int plot = (int)((long long)flowers * i / extraShields);
+        input.extraShields[i] = (Vector2){
+            (plot % game->garden.columns) * GARDEN_PLOT_WIDTH + GARDEN_FLOWER_LINE - 8,
+            (plot / game->garden.columns) * GARDEN_PLOT_HEIGHT + GARDEN_GROUND_LEVEL - 10,
+        };
+    }
+    input.extraShieldCount = extraShields;
+    const int weatherTicks = 250;
+    long long tick = 0;
+    long long ticks = 0;
+    double elapsed = 0;
+    for (; tick < weatherTicks; tick++) {
+        if (tick % BENCH_BATCH_TICKS == 0) ReviveGarden(game);
+        SimStep(game, (Input){0}, PHYSICS_TIME);
+    }
+    while (elapsed < suite->seconds) {
+        ReviveGarden(game);
+        const double start = BenchNow();
+        for (int i = 0; i < BENCH_BATCH_TICKS; i++, tick++) {
+            input.toggleWeather = tick % weatherTicks == 0;
+            SimStep(game, input, PHYSICS_TIME);
+        }
+        elapsed += BenchNow() - start;
+        ticks += BENCH_BATCH_TICKS;
+    }
+    char name[64];
+    const char *prefix = extraShields > 0 ? "garden_shields" : "garden";
+    snprintf(name, sizeof(name), "%s_ticks_per_sec", prefix);
+    BenchReport(suite, name, ticks / elapsed, "ticks/s", true);
+    snprintf(name, sizeof(name), "%s_ns_per_flower", prefix);
+    BenchReport(suite, name, elapsed * 1e9 / ((double)ticks * flowers), "ns", false);
+    SimFree(game);
+    free(game);
+}
+
+// Whole weather field ticks, wind then rain with a shield in the band. The
+// grid is the same at every capacity, so this should be too
+static void BenchWeatherField(BenchSuite *suite) {
+    Game *game = calloc(1, sizeof(Game));
+    if (game == NULL || !SimInitWeatherField(game)) exit(1);
+    SimSeed(game, 1);
+    SimReset(game);
+    game->shields[0] = (Vector2){ FLOWER_LINE - 20, NATIVE_HEIGHT - 20 };
+    game->shieldCount = 1;
+    long long ticks = 0;
+    double elapsed = 0;
+    while (elapsed < suite->seconds) {
+        game->isSunUp = (ticks / BENCH_BATCH_TICKS) % 2 == 0;
+        game->flower.health = 1e9f;
+        const double start = BenchNow();
+        for (int i = 0; i < BENCH_BATCH_TICKS; i++) {
+            UpdateWeatherField(game, PHYSICS_TIME);
+        }
+        elapsed += BenchNow() - start;
+        ticks += BENCH_BATCH_TICKS;
+    }
+    BenchReport(suite, "weather_field_ticks_per_sec", ticks / elapsed, "ticks/s", true);
+    BenchReport(suite, "weather_field_ns_per_cell", elapsed * 1e9 / ((double)ticks * WEATHER_WIDTH * WEATHER_HEIGHT), "ns", false);
+    SimFree(game);
+    free(game);
+}
+
+// Full stores nudged by BENCH_DELTA every tick. That only changes the low
+// mantissa bytes of the positions, so this is the deltas' good case, near the
+// floor of what a tick costs: real play moves particles further and respawns
+// them, and records more bytes per tick than this reports
+static void BenchSnapshots(BenchSuite *suite) {
+    Game *game = NewBenchGame(suite);
+    FillWind(game);
+    FillWater(game);
+    SnapshotRing *ring = SnapshotRingCreate(BENCH_BATCH_TICKS, 64 << 20, 60);
+    if (ring == NULL) exit(1);
+    long long records = 0;
+    long long restores = 0;
+    double recordElapsed = 0;
+    double restoreElapsed = 0;
+    double bytes = 0;
+    while (recordElapsed + restoreElapsed < suite->seconds) {
+        SnapshotRingReset(ring);
+        for (int i = 0; i < BENCH_BATCH_TICKS; i++) {
+            SimStep(game, (Input){0}, BENCH_DELTA);
+            const double start = BenchNow();
+            SnapshotRingRecord(ring, game);
+            recordElapsed += BenchNow() - start;
+        }
+        records += BENCH_BATCH_TICKS;
+        bytes += SnapshotRingBytes(ring);
+        // The newest tick, a keyframe and a delta to decode
+        const double start = BenchNow();
+        const bool restored = SnapshotRingRestore(ring, SnapshotRingNewest(ring), game);
+        restoreElapsed += BenchNow() - start;
+        if (!restored) {
+            fprintf(stderr, "snapshot of tick %lld didn't restore\n", SnapshotRingNewest(ring));
+            exit(1);
+        }
+        restores++;
+    }
+    BenchReport(suite, "snapshot_record_us", recordElapsed * 1e6 / records, "us", false);
+    BenchReport(suite, "snapshot_restore_us", restoreElapsed * 1e6 / restores, "us", false);
+    BenchReport(suite, "snapshot_bytes_per_tick", bytes / records, "B", false);
+    SnapshotRingDestroy(ring);
+    SimFree(game);
+    free(game);
+}
+
+int main(int argc, char **argv) {
+    BenchSuite suite = { .threshold = 0.10, .seconds = 0.25, .capacity = DEFAULT_WIND_CAPACITY };
+    if (!BenchParseArgs(&suite, argc, argv)) return 1;
+    char suiteName[32];
+    snprintf(suiteName, sizeof(suiteName), "sim-%d", suite.capacity);
+    suite.name = suiteName;
+    srand(1);
+    jobs = JobSystemCreate(suite.threads);
+
+    printf("%s (%d particles per store, %d threads)\n", suite.name, suite.capacity, JobsThreadCount(jobs));
+    BenchParticles(&suite, true, 1);
+    BenchParticles(&suite, false, 1);
+    BenchParticles(&suite, true, MAX_SHIELDS);
+    BenchTakeDamage(&suite);
+    BenchTakeWater(&suite);
+    BenchGarden(&suite, 0);
+    BenchGarden(&suite, MAX_SHIELDS - 1);
+    BenchWeatherField(&suite);
+    BenchSnapshots(&suite);
+    JobSystemDestroy(jobs);
+    return BenchFinish(&suite);
+}
@@ -0,0 +1,195 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // mmap, fstat
+#endif
+
+#include "asset_pack.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ASSET_PACK_MMAP
+#endif
+
+static uint32_t ReadU32(const unsigned char *bytes) {
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static bool MapFile(AssetPack *pack, const char *path) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    }
+    CloseHandle(file);
+    if (mapping == NULL) return false;
+    pack->data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (pack->data == NULL) {
+        CloseHandle(mapping);
+        return false;
+    }
+    pack->size = (size_t)size.QuadPart;
+    pack->mapping = mapping;
+    pack->mapped = true;
+    return true;
+#elif defined(ASSET_PACK_MMAP)
+    const int file = open(path, O_RDONLY);
+    if (file < 0) return false;
+    struct stat info;
+    void *data = MAP_FAILED;
+    if (fstat(file, &info) == 0 && info.st_size > 0) {
+        data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    }
+    close(file);
+    if (data == MAP_FAILED) return false;
+    // One sequential read-ahead instead of a page fault per blob
+    posix_madvise(data, (size_t)info.st_size, POSIX_MADV_WILLNEED);
+    pack->data = data;
+    pack->size = (size_t)info.st_size;
+    pack->mapped = true;
+    return true;
+#else
+    (void)pack;
+    (void)path;
+    return false;
+#endif
+}
+
+// Web: the pack is the one preloaded file, read it whole
+static bool ReadFile(AssetPack *pack, const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return false;
+    unsigned char *data = NULL;
+    long size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) size = ftell(file);
+    if (size > 0 && fseek(file, 0, SEEK_SET) == 0) data = malloc((size_t)size);
+    if (data != NULL && fread(data, 1, (size_t)size, file) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    if (data == NULL) return false;
+    pack->data = data;
+    pack->size = (size_t)size;
+    return true;
+}
+
+bool AssetPackOpen(AssetPack *pack, const char *path) {
+    *pack = (AssetPack){0};
+    if (!MapFile(pack, path) && !ReadFile(pack, path)) return false;
+
+    const unsigned char *header = pack->data;
+    const bool valid = pack->size >= ASSET_HEADER_SIZE && memcmp(header, "PBPK", 4) == 0 &&
+        ReadU32(header + 4) == ASSET_PACK_VERSION &&
+        ReadU32(header + 8) <= (pack->size - ASSET_HEADER_SIZE) / ASSET_ENTRY_SIZE;
+    if (!valid) {
+        AssetPackClose(pack);
+        return false;
+    }
+    pack->entryCount = (int)ReadU32(header + 8);
+    return true;
+}
+
+void AssetPackClose(AssetPack *pack) {
+#if defined(_WIN32)
+    if (pack->mapped) {
+        UnmapViewOfFile(pack->data);
+        CloseHandle(pack->mapping);
+    }
+#elif defined(ASSET_PACK_MMAP)
+    if (pack->mapped) munmap((void *)pack->data, pack->size);
+#endif
+    if (!pack->mapped) free((void *)pack->data);
+    *pack = (AssetPack){0};
+}
+
+bool AssetPackLoad(const AssetPack *pack, const char *name, AssetBlob *blob) {
+    *blob = (AssetBlob){0};
+    for (int i = 0; i < pack->entryCount; i++) {
+        const unsigned char *entry = pack->data + ASSET_HEADER_SIZE + (size_t)i * ASSET_ENTRY_SIZE;
+        if (strncmp((const char *)entry, name, ASSET_NAME_SIZE) != 0) continue;
+
+        const uint32_t offset = ReadU32(entry + ASSET_NAME_SIZE);
+        const uint32_t storedSize = ReadU32(entry + ASSET_NAME_SIZE + 4);
+        const uint32_t decodedSize = ReadU32(entry + ASSET_NAME_SIZE + 8);
+        const uint32_t codec = ReadU32(entry + ASSET_NAME_SIZE + 12);
+        if (offset > pack->size || storedSize > pack->size - offset || decodedSize > INT32_MAX) return false;
+        const unsigned char *stored = pack->data + offset;
+
+        if (codec == AssetCodecStored) {
+            *blob = (AssetBlob){ stored, (int)storedSize, false };
+            return true;
+        }
+        if (codec != AssetCodecLz4) return false;
+        unsigned char *decoded = malloc(decodedSize > 0 ? decodedSize : 1);
+        if (decoded == NULL) return false;
+        if (Lz4DecompressBlock(stored, (int)storedSize, decoded, (int)decodedSize) != (int)decodedSize) {
+            free(decoded);
+            return false;
+        }
+        *blob = (AssetBlob){ decoded, (int)decodedSize, true };
+        return true;
+    }
+    return false;
+}
+
+void AssetBlobFree(AssetBlob *blob) {
+    if (blob->owned) free((void *)blob->data);
+    *blob = (AssetBlob){0};
+}
+
+// Adds up a 4-bit length field and its 255-continued extension
+static bool ReadLength(const unsigned char **in, const unsigned char *end, int *length) {
+    if (*length != 15) return true;
+    unsigned char byte;
+    do {
+        if (*in >= end) return false;
+        byte = *(*in)++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+int Lz4DecompressBlock(const unsigned char *source, int sourceSize, unsigned char *destination, int destinationCapacity) {
+    const unsigned char *in = source;
+    const unsigned char *inEnd = source + sourceSize;
+    unsigned char *out = destination;
+    unsigned char *outEnd = destination + destinationCapacity;
+    while (in < inEnd) {
+        const unsigned char token = *in++;
+        int literals = token >> 4;
+        if (!ReadLength(&in, inEnd, &literals)) return -1;
+        if (literals > inEnd - in || literals > outEnd - out) return -1;
+        memcpy(out, in, literals);
+        in += literals;
+        out += literals;
+        // The last sequence is literals only
+        if (in == inEnd) break;
+
+        if (inEnd - in < 2) return -1;
+        const int distance = in[0] | (in[1] << 8);
+        in += 2;
+        if (distance == 0 || distance > out - destination) return -1;
+        int match = token & 15;
+        if (!ReadLength(&in, inEnd, &match)) return -1;
+        match += 4;
+        if (match > outEnd - out) return -1;
+        // Byte by byte: the match may overlap what it's writing
+        const unsigned char *from = out - distance;
+        for (int k = 0; k < match; k++) out[k] = from[k];
+        out += match;
+    }
+    return (int)(out - destination);
+}
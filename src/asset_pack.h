@@ -0,0 +1,54 @@
+#ifndef PIXEL_BLOOM_ASSET_PACK_H
+#define PIXEL_BLOOM_ASSET_PACK_H
+
+// Single-file asset pack written by tools/asset_packer.c. Layout, all
+// integers little-endian:
+//
+//   "PBPK"  u32 version  u32 entryCount  u32 reserved
+//   entryCount x { char name[48]  u32 offset  u32 storedSize  u32 decodedSize  u32 codec }
+//   blobs, each 16-byte aligned
+//
+// The whole file is mapped (desktop) or read in one go (web, where the game
+// fetches it after the first frame), so opening it is one sequential read.
+// Stored blobs are handed out in place; LZ4 blobs are decoded into a buffer
+// of the precomputed size.
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ASSET_PACK_VERSION 1
+#define ASSET_NAME_SIZE 48
+#define ASSET_HEADER_SIZE 16
+#define ASSET_ENTRY_SIZE 64
+#define ASSET_ALIGNMENT 16
+
+typedef enum AssetCodec {
+    AssetCodecStored = 0,
+    AssetCodecLz4 = 1,      // one LZ4 block
+} AssetCodec;
+
+typedef struct AssetPack {
+    const unsigned char *data;
+    size_t size;
+    int entryCount;
+    bool mapped;            // data is a file mapping rather than malloc'd
+    void *mapping;          // Windows file mapping handle
+} AssetPack;
+
+typedef struct AssetBlob {
+    const unsigned char *data;
+    int size;
+    bool owned;             // decoded copy, freed by AssetBlobFree
+} AssetBlob;
+
+bool AssetPackOpen(AssetPack *pack, const char *path);
+// Blobs handed out in place die with the pack
+void AssetPackClose(AssetPack *pack);
+// Returns false when name isn't in the pack or its blob is corrupt
+bool AssetPackLoad(const AssetPack *pack, const char *name, AssetBlob *blob);
+void AssetBlobFree(AssetBlob *blob);
+
+// Decodes one LZ4 block, returns the decoded size or -1 when it's malformed
+int Lz4DecompressBlock(const unsigned char *source, int sourceSize, unsigned char *destination, int destinationCapacity);
+
+#endif // PIXEL_BLOOM_ASSET_PACK_H
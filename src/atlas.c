@@ -0,0 +1,22 @@
+#include "atlas.h"
+
+Texture2D LoadAtlasTexture(void) {
+    // LoadTextureFromImage only reads the pixels, they stay in the executable
+    const Image image = {
+        .data = (void *)SpriteSheetPixels(),
+        .width = SpriteSheetWidth(),
+        .height = SpriteSheetHeight(),
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+    };
+    return LoadTextureFromImage(image);
+}
+
+int AtlasFrameCount(SpriteId sprite) {
+    return SpriteFrameCount(sprite);
+}
+
+Rectangle AtlasFrame(SpriteId sprite, int frame) {
+    const SpriteRect rect = SpriteFrameRect(sprite, frame);
+    return (Rectangle){ (float)rect.x, (float)rect.y, (float)rect.width, (float)rect.height };
+}
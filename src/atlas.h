@@ -0,0 +1,17 @@
+#ifndef PIXEL_BLOOM_ATLAS_H
+#define PIXEL_BLOOM_ATLAS_H
+
+// Every sprite of the game, packed into one texture at build time by
+// tools/atlas_packer.c (see CMakeLists.txt). The pixels are compiled into the
+// executable, so loading them is one GPU upload with no file I/O or PNG
+// decode, and the whole scene draws from a single texture.
+
+#include "raylib.h"
+#include "sprite_sheet.h"
+
+Texture2D LoadAtlasTexture(void);
+int AtlasFrameCount(SpriteId sprite);
+// Source rectangle of one frame, wraps around the sprite's frame count
+Rectangle AtlasFrame(SpriteId sprite, int frame);
+
+#endif // PIXEL_BLOOM_ATLAS_H
@@ -0,0 +1,147 @@
+#include "background_music.h"
+#include "profiler.h"
+
+#include "raylib.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+#if (!defined(PLATFORM_WEB) || defined(__EMSCRIPTEN_PTHREADS__)) && !defined(__STDC_NO_THREADS__)
+#include <threads.h>
+#define MUSIC_DECODER_THREAD
+#endif
+
+#define MUSIC_BUFFER_FRAMES 16384   // each half of the stream's buffer, ~0.4s at 44.1kHz
+#define MUSIC_DECODER_NAP_MS 10     // between checks for a half that played out
+
+static struct {
+    unsigned int channels;
+    bool playing;
+    atomic_bool paused;
+    atomic_int underruns;
+#if defined(MUSIC_DECODER_THREAD)
+    Music track;                // only the decoder thread touches it once playing
+    uint64_t bufferNs;          // how long the whole stream buffer plays
+    atomic_bool running;
+    thrd_t thread;
+#else
+    // raylib's stream callbacks take no user pointer, so there is one player
+    AudioStream stream;
+    Wave wave;                  // the whole track, decoded at start
+    uint64_t position;          // callback only
+#endif
+} music;
+
+#if defined(MUSIC_DECODER_THREAD)
+
+// Refills whichever half of the stream's buffer played out, and applies pause
+// commands, so every raylib call on the track happens here
+static int DecodeMusic(void *data) {
+    (void)data;
+    const struct timespec nap = { 0, MUSIC_DECODER_NAP_MS * 1000000L };
+    bool paused = false;
+    uint64_t lastRefill = ProfilerNow();
+    while (atomic_load(&music.running)) {
+        const bool wantPaused = atomic_load_explicit(&music.paused, memory_order_relaxed);
+        if (wantPaused != paused) {
+            paused = wantPaused;
+            if (paused) {
+                PauseMusicStream(music.track);
+            } else {
+                ResumeMusicStream(music.track);
+                lastRefill = ProfilerNow();
+            }
+        }
+        if (!paused && IsAudioStreamProcessed(music.track.stream)) {
+            const uint64_t now = ProfilerNow();
+            // Refills come every half buffer. Later than a whole one, and the
+            // device already played silence
+            if (now - lastRefill > music.bufferNs) {
+                atomic_fetch_add_explicit(&music.underruns, 1, memory_order_relaxed);
+            }
+            UpdateMusicStream(music.track);
+            lastRefill = now;
+        }
+        thrd_sleep(&nap, NULL);
+    }
+    return 0;
+}
+
+#else
+
+// Audio thread, or the browser's audio callback on web
+static void PlayMusicCallback(void *buffer, unsigned int frames) {
+    int16_t *out = buffer;
+    const int16_t *track = music.wave.data;
+    const uint64_t trackFrames = music.wave.frameCount;
+    if (atomic_load_explicit(&music.paused, memory_order_relaxed) || trackFrames == 0) {
+        memset(out, 0, sizeof(int16_t) * frames * music.channels);
+        return;
+    }
+    while (frames > 0) {
+        uint64_t count = trackFrames - music.position;
+        if (count > frames) count = frames;
+        memcpy(out, track + music.position * music.channels, sizeof(int16_t) * count * music.channels);
+        out += count * music.channels;
+        frames -= (unsigned int)count;
+        music.position = (music.position + count) % trackFrames;
+    }
+}
+
+#endif
+
+bool BackgroundMusicPlay(const unsigned char *mp3, int size) {
+    if (music.playing) return false;
+    atomic_store(&music.paused, false);
+    atomic_store(&music.underruns, 0);
+#if defined(MUSIC_DECODER_THREAD)
+    SetAudioStreamBufferSizeDefault(MUSIC_BUFFER_FRAMES);
+    music.track = LoadMusicStreamFromMemory(".mp3", mp3, size);
+    SetAudioStreamBufferSizeDefault(0);
+    if (!IsMusicValid(music.track)) return false;
+    music.channels = music.track.stream.channels;
+    music.bufferNs = (uint64_t)MUSIC_BUFFER_FRAMES * 2 * 1000000000u / music.track.stream.sampleRate;
+    // The buffer starts full, so the first callbacks don't wait on the thread
+    UpdateMusicStream(music.track);
+    PlayMusicStream(music.track);
+    atomic_store(&music.running, true);
+    if (thrd_create(&music.thread, DecodeMusic, NULL) != thrd_success) {
+        UnloadMusicStream(music.track);
+        return false;
+    }
+#else
+    music.wave = LoadWaveFromMemory(".mp3", mp3, size);
+    if (!IsWaveValid(music.wave)) return false;
+    WaveFormat(&music.wave, music.wave.sampleRate, 16, music.wave.channels);
+    music.channels = music.wave.channels;
+    music.position = 0;
+    music.stream = LoadAudioStream(music.wave.sampleRate, 16, music.channels);
+    SetAudioStreamCallback(music.stream, PlayMusicCallback);
+    PlayAudioStream(music.stream);
+#endif
+    music.playing = true;
+    return true;
+}
+
+void BackgroundMusicSetPaused(bool paused) {
+    atomic_store_explicit(&music.paused, paused, memory_order_relaxed);
+}
+
+int BackgroundMusicUnderruns(void) {
+    return atomic_load_explicit(&music.underruns, memory_order_relaxed);
+}
+
+void BackgroundMusicStop(void) {
+    if (!music.playing) return;
+#if defined(MUSIC_DECODER_THREAD)
+    atomic_store(&music.running, false);
+    thrd_join(music.thread, NULL);
+    UnloadMusicStream(music.track);
+#else
+    // The callback reads the track until the stream is gone
+    UnloadAudioStream(music.stream);
+    UnloadWave(music.wave);
+#endif
+    music.playing = false;
+}
@@ -0,0 +1,25 @@
+#ifndef PIXEL_BLOOM_BACKGROUND_MUSIC_H
+#define PIXEL_BLOOM_BACKGROUND_MUSIC_H
+
+// Looping music that never waits on the frame loop. A decoder thread owns a
+// raylib Music stream and refills each half of its buffer as soon as the
+// device played it out, so decoding never lands on the frame. The game thread
+// only sends commands (pause, resume).
+//
+// Without C11 threads (web builds without PIXEL_BLOOM_WEB_THREADS) the whole
+// track is decoded once at start and an AudioStream callback plays it from
+// memory: no decoding on the frame either way.
+
+#include <stdbool.h>
+
+// mp3 must stay valid until BackgroundMusicStop. Call after InitAudioDevice,
+// returns false when the data isn't an MP3 or out of memory
+bool BackgroundMusicPlay(const unsigned char *mp3, int size);
+void BackgroundMusicSetPaused(bool paused);
+// Refills that came later than the whole buffer lasts, each one a crackle.
+// Timed from the decoder thread, so an estimate rather than a device count
+int BackgroundMusicUnderruns(void);
+// Call before CloseAudioDevice
+void BackgroundMusicStop(void);
+
+#endif // PIXEL_BLOOM_BACKGROUND_MUSIC_H
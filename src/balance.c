@@ -0,0 +1,362 @@
+// pixel-bloom-balance: Monte Carlo balancing. Plays a policy through every
+// point of a grid over the Tuning constants, many independent sessions per
+// point spread over every core, and prints survival, score and cause of death
+// per point.
+//
+//     pixel-bloom-balance --grid flowerWaterDrainSpeed=6:14:2 --grid windParticlesCD=.3,.5,.8 --csv balance.csv
+//
+// Session i of every point is seeded the same way, so points are compared over
+// the same weather (common random numbers) and the tables come out the same on
+// any number of threads.
+
+#include "sim.h"
+#include "policy.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_AXIS_VALUES 64
+#define SESSION_GRAIN 16    // sessions per job chunk at least
+#define MAX_HISTOGRAM_BUCKETS 1024
+
+typedef struct TuningParameter {
+    const char *name;
+    size_t offset;          // of the float in Tuning
+} TuningParameter;
+
+static const TuningParameter PARAMETERS[] = {
+    { "flowerWaterDrainSpeed", offsetof(Tuning, flowerWaterDrainSpeed) },
+    { "windParticlesCD", offsetof(Tuning, windParticlesCD) },
+    { "waterParticlesCD", offsetof(Tuning, waterParticlesCD) },
+    { "dehidrationDamage", offsetof(Tuning, dehidrationDamage) },
+    { "tooMuchWaterDamage", offsetof(Tuning, tooMuchWaterDamage) },
+};
+#define PARAMETER_COUNT ((int)(sizeof(PARAMETERS) / sizeof(PARAMETERS[0])))
+
+typedef struct GridAxis {
+    int parameter;
+    float values[MAX_AXIS_VALUES];
+    int count;
+} GridAxis;
+
+typedef struct BalanceOptions {
+    int sessions;           // per grid point
+    int capacity;
+    float delta;
+    float maxSeconds;
+    uint64_t seed;
+    int threads;
+    Policy policy;
+    const char *csvPath;
+    GridAxis axes[PARAMETER_COUNT];
+    int axisCount;
+} BalanceOptions;
+
+typedef struct BalanceStats {
+    long long sessions;
+    long long ticks;
+    double survival;        // seconds, summed
+    double survivalSquares;
+    double score;
+    long long deaths[DrawningDamage + 1]; // NoneDamage is alive at --max-seconds
+    long long outOfMemory;
+} BalanceStats;
+
+// One grid point: every chunk fills its own stats and survival histogram
+typedef struct BalanceBatch {
+    const BalanceOptions *options;
+    Tuning tuning;
+    BalanceStats chunks[JOB_MAX_CHUNKS];
+    long long *histograms;  // JOB_MAX_CHUNKS x bucketCount of survival times
+    int bucketCount;
+    float bucketSeconds;
+} BalanceBatch;
+
+static double WallSeconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static float *TuningValue(Tuning *tuning, int parameter) {
+    return (float *)((char *)tuning + PARAMETERS[parameter].offset);
+}
+
+// splitmix64, a different stream for every session index
+static uint64_t SessionSeed(uint64_t seed, int session) {
+    uint64_t z = seed + (uint64_t)(session + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void RunSessionsJob(void *data, int chunk, int begin, int end) {
+    BalanceBatch *batch = data;
+    const BalanceOptions *options = batch->options;
+    BalanceStats *stats = &batch->chunks[chunk];
+    long long *histogram = batch->histograms + (size_t)chunk * batch->bucketCount;
+    *stats = (BalanceStats){0};
+    memset(histogram, 0, sizeof(long long) * batch->bucketCount);
+
+    // Sessions are already spread over the threads, so each runs its particle
+    // passes inline
+    Game *game = calloc(1, sizeof(Game));
+    if (game == NULL || !SimInit(game, options->capacity, options->capacity)) {
+        free(game);
+        stats->outOfMemory = end - begin;
+        return;
+    }
+    game->tuning = batch->tuning;
+    const long long maxTicks = (long long)(options->maxSeconds / options->delta + 0.5f);
+    for (int session = begin; session < end; session++) {
+        SimReset(game);
+        SimSeed(game, SessionSeed(options->seed, session));
+        game->state = StateInGame;
+        long long tick = 0;
+        while (game->state == StateInGame && tick < maxTicks) {
+            SimStep(game, PolicyInput(options->policy, game, tick, options->delta), options->delta);
+            tick++;
+        }
+        const double survival = tick * (double)options->delta;
+        int bucket = (int)(survival / batch->bucketSeconds);
+        if (bucket >= batch->bucketCount) bucket = batch->bucketCount - 1;
+        histogram[bucket]++;
+        stats->sessions++;
+        stats->ticks += tick;
+        stats->survival += survival;
+        stats->survivalSquares += survival * survival;
+        stats->score += game->score;
+        stats->deaths[game->gameOverType]++;
+    }
+    SimFree(game);
+    free(game);
+}
+
+// Survival time the given fraction of sessions died before, to the bucket
+static float HistogramPercentile(const BalanceBatch *batch, const long long *histogram, long long sessions, double fraction) {
+    const long long rank = (long long)ceil(sessions * fraction);
+    long long seen = 0;
+    for (int i = 0; i < batch->bucketCount; i++) {
+        seen += histogram[i];
+        if (seen >= rank && seen > 0) return i * batch->bucketSeconds;
+    }
+    return (batch->bucketCount - 1) * batch->bucketSeconds;
+}
+
+static bool ParseAxis(const char *spec, GridAxis *axis) {
+    const char *equals = strchr(spec, '=');
+    if (equals == NULL) return false;
+    axis->parameter = -1;
+    for (int i = 0; i < PARAMETER_COUNT; i++) {
+        if (strlen(PARAMETERS[i].name) == (size_t)(equals - spec) && strncmp(spec, PARAMETERS[i].name, equals - spec) == 0) {
+            axis->parameter = i;
+        }
+    }
+    if (axis->parameter < 0) return false;
+
+    const char *list = equals + 1;
+    float start, stop, step;
+    char tail;
+    axis->count = 0;
+    // start:stop:step, stop included
+    if (sscanf(list, "%f:%f:%f%c", &start, &stop, &step, &tail) == 3) {
+        if (!(step > 0) || stop < start) return false;
+        for (int i = 0; axis->count < MAX_AXIS_VALUES; i++) {
+            const float value = start + i * step;
+            if (value > stop + step * 1e-3f) break;
+            axis->values[axis->count++] = value;
+        }
+        return true;
+    }
+    // v1,v2,...
+    const char *cursor = list;
+    while (*cursor != '\0' && axis->count < MAX_AXIS_VALUES) {
+        char *end;
+        axis->values[axis->count++] = strtof(cursor, &end);
+        if (end == cursor || (*end != ',' && *end != '\0')) return false;
+        cursor = (*end == ',') ? end + 1 : end;
+    }
+    return axis->count > 0 && *cursor == '\0';
+}
+
+static void PrintUsage(const char *program) {
+    printf("usage: %s [--grid NAME=v1,v2,...|NAME=start:stop:step]... [--sessions N] [--capacity PARTICLES] [--dt SECONDS] [--max-seconds SECONDS] [--seed N] [--threads N] [--policy idle|bot|cycle:SECONDS] [--csv FILE]\n", program);
+    printf("grid parameters:");
+    for (int i = 0; i < PARAMETER_COUNT; i++) printf(" %s", PARAMETERS[i].name);
+    printf("\n");
+}
+
+static bool ParseOptions(int argc, char **argv, BalanceOptions *options) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--help") == 0) {
+            return false;
+        }
+        if (value == NULL) {
+            fprintf(stderr, "missing value for %s\n", arg);
+            return false;
+        }
+        if (strcmp(arg, "--grid") == 0) {
+            GridAxis axis;
+            if (!ParseAxis(value, &axis)) {
+                fprintf(stderr, "bad grid axis %s\n", value);
+                return false;
+            }
+            for (int a = 0; a < options->axisCount; a++) {
+                if (options->axes[a].parameter == axis.parameter) {
+                    fprintf(stderr, "%s is on the grid twice\n", PARAMETERS[axis.parameter].name);
+                    return false;
+                }
+            }
+            options->axes[options->axisCount++] = axis;
+        } else if (strcmp(arg, "--sessions") == 0) {
+            options->sessions = atoi(value);
+        } else if (strcmp(arg, "--capacity") == 0) {
+            options->capacity = atoi(value);
+        } else if (strcmp(arg, "--dt") == 0) {
+            options->delta = (float)atof(value);
+        } else if (strcmp(arg, "--max-seconds") == 0) {
+            options->maxSeconds = (float)atof(value);
+        } else if (strcmp(arg, "--seed") == 0) {
+            options->seed = strtoull(value, NULL, 10);
+        } else if (strcmp(arg, "--threads") == 0) {
+            options->threads = atoi(value);
+        } else if (strcmp(arg, "--policy") == 0) {
+            if (!PolicyParse(value, &options->policy)) {
+                fprintf(stderr, "unknown policy %s\n", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--csv") == 0) {
+            options->csvPath = value;
+        } else {
+            fprintf(stderr, "unknown option %s\n", arg);
+            return false;
+        }
+        i++;
+    }
+    return options->sessions > 0 && options->capacity > 0 && options->delta > 0 && options->maxSeconds > 0;
+}
+
+int main(int argc, char **argv) {
+    BalanceOptions options = {
+        .sessions = 10000,
+        .capacity = DEFAULT_WIND_CAPACITY,
+        .delta = PHYSICS_TIME,
+        .maxSeconds = 300,
+        .seed = 1,
+        .policy = { PolicyBot, 0 },
+    };
+    if (!ParseOptions(argc, argv, &options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    int pointCount = 1;
+    for (int a = 0; a < options.axisCount; a++) pointCount *= options.axes[a].count;
+    BalanceBatch *batch = calloc(1, sizeof(BalanceBatch));
+    if (batch != NULL) {
+        batch->options = &options;
+        // Second wide buckets, wider past MAX_HISTOGRAM_BUCKETS seconds
+        batch->bucketSeconds = options.maxSeconds > MAX_HISTOGRAM_BUCKETS - 1 ? options.maxSeconds / (MAX_HISTOGRAM_BUCKETS - 1) : 1;
+        batch->bucketCount = (int)(options.maxSeconds / batch->bucketSeconds) + 1;
+        batch->histograms = malloc(sizeof(long long) * JOB_MAX_CHUNKS * batch->bucketCount);
+    }
+    long long *histogram = malloc(sizeof(long long) * (batch != NULL ? batch->bucketCount : 1));
+    JobSystem *jobs = JobSystemCreate(options.threads);
+    if (batch == NULL || batch->histograms == NULL || histogram == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    FILE *csv = NULL;
+    if (options.csvPath != NULL) {
+        csv = fopen(options.csvPath, "w");
+        if (csv == NULL) {
+            fprintf(stderr, "can't write %s\n", options.csvPath);
+            return 1;
+        }
+        for (int i = 0; i < PARAMETER_COUNT; i++) fprintf(csv, "%s,", PARAMETERS[i].name);
+        fprintf(csv, "sessions,survival_mean,survival_stddev,survival_p10,survival_p50,survival_p90,score_mean,alive,dehidration,wind,drawning\n");
+    }
+
+    printf("%d points x %d sessions, %.0f s limit, %d threads\n", pointCount, options.sessions, options.maxSeconds, JobsThreadCount(jobs));
+    for (int a = 0; a < options.axisCount; a++) printf("%-22s ", PARAMETERS[options.axes[a].parameter].name);
+    printf("survival s: mean  stddev  p10  p50  p90 |  score | alive  dehidr.   wind  drawn.\n");
+
+    long long totalTicks = 0;
+    long long totalSessions = 0;
+    const double start = WallSeconds();
+    for (int point = 0; point < pointCount; point++) {
+        // Mixed radix over the axes, the first one changing slowest
+        batch->tuning = SimDefaultTuning();
+        int rest = point;
+        for (int a = options.axisCount - 1; a >= 0; a--) {
+            const GridAxis *axis = &options.axes[a];
+            *TuningValue(&batch->tuning, axis->parameter) = axis->values[rest % axis->count];
+            rest /= axis->count;
+        }
+
+        const int chunks = JobsParallelFor(jobs, options.sessions, SESSION_GRAIN, RunSessionsJob, batch);
+        BalanceStats stats = {0};
+        memset(histogram, 0, sizeof(long long) * batch->bucketCount);
+        for (int chunk = 0; chunk < chunks; chunk++) {
+            const BalanceStats *part = &batch->chunks[chunk];
+            stats.sessions += part->sessions;
+            stats.ticks += part->ticks;
+            stats.survival += part->survival;
+            stats.survivalSquares += part->survivalSquares;
+            stats.score += part->score;
+            stats.outOfMemory += part->outOfMemory;
+            for (int d = 0; d <= DrawningDamage; d++) stats.deaths[d] += part->deaths[d];
+            for (int b = 0; b < batch->bucketCount; b++) histogram[b] += batch->histograms[(size_t)chunk * batch->bucketCount + b];
+        }
+        if (stats.outOfMemory > 0) {
+            fprintf(stderr, "%lld sessions skipped, can't allocate %d particles\n", stats.outOfMemory, options.capacity);
+        }
+        if (stats.sessions == 0) continue;
+        totalTicks += stats.ticks;
+        totalSessions += stats.sessions;
+
+        const double sessions = (double)stats.sessions;
+        const double mean = stats.survival / sessions;
+        const double variance = stats.survivalSquares / sessions - mean * mean;
+        const double stddev = variance > 0 ? sqrt(variance) : 0;
+        const float p10 = HistogramPercentile(batch, histogram, stats.sessions, 0.1);
+        const float p50 = HistogramPercentile(batch, histogram, stats.sessions, 0.5);
+        const float p90 = HistogramPercentile(batch, histogram, stats.sessions, 0.9);
+        for (int a = 0; a < options.axisCount; a++) {
+            printf("%-22g ", *TuningValue(&batch->tuning, options.axes[a].parameter));
+        }
+        printf("          %7.1f %7.1f %4.0f %4.0f %4.0f | %6.1f | %4.1f%%  %5.1f%%  %5.1f%%  %5.1f%%\n",
+            mean, stddev, p10, p50, p90, stats.score / sessions,
+            100 * stats.deaths[NoneDamage] / sessions, 100 * stats.deaths[DehidrationDamage] / sessions,
+            100 * stats.deaths[WindDamage] / sessions, 100 * stats.deaths[DrawningDamage] / sessions);
+        if (csv != NULL) {
+            for (int i = 0; i < PARAMETER_COUNT; i++) fprintf(csv, "%g,", *TuningValue(&batch->tuning, i));
+            fprintf(csv, "%lld,%.3f,%.3f,%g,%g,%g,%.3f,%lld,%lld,%lld,%lld\n", stats.sessions, mean, stddev, p10, p50, p90,
+                stats.score / sessions, stats.deaths[NoneDamage], stats.deaths[DehidrationDamage],
+                stats.deaths[WindDamage], stats.deaths[DrawningDamage]);
+        }
+    }
+    const double elapsed = WallSeconds() - start;
+    printf("%lld sessions, %lld ticks in %.2f s (%.0f ticks/s)\n", totalSessions, totalTicks, elapsed,
+        elapsed > 0 ? totalTicks / elapsed : 0.0);
+
+    int status = 0;
+    if (csv != NULL) {
+        const bool ok = ferror(csv) == 0;
+        if (fclose(csv) != 0 || !ok) {
+            fprintf(stderr, "can't write %s\n", options.csvPath);
+            status = 1;
+        }
+    }
+    JobSystemDestroy(jobs);
+    free(histogram);
+    free(batch->histograms);
+    free(batch);
+    return status;
+}
@@ -0,0 +1,112 @@
+#include "frame_capture.h"
+#include "rlgl.h"
+
+#include <string.h>
+
+#if defined(PLATFORM_DESKTOP) && defined(PIXEL_BLOOM_RAYLIB_GLAD)
+// The GL loader raylib already links in, for the calls rlgl doesn't wrap. Only
+// a raylib built from source has its header (CMakeLists.txt)
+#include "external/glad.h"
+#define CAPTURE_PIXEL_BUFFERS
+#endif
+
+// Read back pixels are bottom row first, the writer wants the top first
+static void CopyFlipped(FrameCapture *capture, const unsigned char *pixels) {
+    unsigned char *slot = FrameWriterBegin(capture->writer, false);
+    if (slot == NULL) return;
+    const size_t stride = (size_t)capture->width * 4;
+    for (int y = 0; y < capture->height; y++) {
+        memcpy(slot + y * stride, pixels + (capture->height - 1 - y) * stride, stride);
+    }
+    FrameWriterCommit(capture->writer);
+}
+
+#if defined(CAPTURE_PIXEL_BUFFERS)
+static void Collect(FrameCapture *capture) {
+    const int index = (int)(capture->collected % CAPTURE_BUFFERS);
+    GLsync fence = capture->fences[index];
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        capture->stalls++;
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    }
+    glDeleteSync(fence);
+    capture->fences[index] = NULL;
+    const GLsizeiptr size = (GLsizeiptr)capture->width * capture->height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->buffers[index]);
+    const unsigned char *pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (pixels != NULL) {
+        CopyFlipped(capture, pixels);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    capture->collected++;
+}
+#endif
+
+bool FrameCaptureStart(FrameCapture *capture, const char *path, int width, int height, int fps) {
+    *capture = (FrameCapture){ .width = width, .height = height };
+    capture->writer = FrameWriterOpen(path, width, height, fps);
+    if (capture->writer == NULL) return false;
+#if defined(CAPTURE_PIXEL_BUFFERS)
+    const int version = rlGetVersion();
+    capture->pixelBuffers = version == RL_OPENGL_33 || version == RL_OPENGL_43;
+    if (capture->pixelBuffers) {
+        glGenBuffers(CAPTURE_BUFFERS, capture->buffers);
+        for (int i = 0; i < CAPTURE_BUFFERS; i++) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->buffers[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * 4, NULL, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+#endif
+    TraceLog(LOG_INFO, "CAPTURE: Recording %ix%i frames to %s (%s readback)", width, height, path,
+        capture->pixelBuffers ? "asynchronous" : "synchronous");
+    return true;
+}
+
+void FrameCaptureTexture(FrameCapture *capture, RenderTexture2D target) {
+    if (capture->writer == NULL) return;
+#if defined(CAPTURE_PIXEL_BUFFERS)
+    if (capture->pixelBuffers) {
+        if (capture->issued - capture->collected == CAPTURE_BUFFERS) Collect(capture);
+        const int index = (int)(capture->issued % CAPTURE_BUFFERS);
+        rlEnableFramebuffer(target.id);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->buffers[index]);
+        glReadPixels(0, 0, capture->width, capture->height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        rlDisableFramebuffer();
+        capture->fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        capture->issued++;
+        return;
+    }
+#endif
+    Image image = LoadImageFromTexture(target.texture);
+    if (image.data != NULL && image.format == PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+        CopyFlipped(capture, image.data);
+    }
+    UnloadImage(image);
+}
+
+void FrameCapturePixels(FrameCapture *capture, const unsigned char *pixels) {
+    if (capture->writer == NULL) return;
+    unsigned char *slot = FrameWriterBegin(capture->writer, false);
+    if (slot == NULL) return;
+    memcpy(slot, pixels, (size_t)capture->width * capture->height * 4);
+    FrameWriterCommit(capture->writer);
+}
+
+void FrameCaptureStop(FrameCapture *capture) {
+    if (capture->writer == NULL) return;
+#if defined(CAPTURE_PIXEL_BUFFERS)
+    if (capture->pixelBuffers) {
+        while (capture->collected < capture->issued) Collect(capture);
+        glDeleteBuffers(CAPTURE_BUFFERS, capture->buffers);
+    }
+#endif
+    const int dropped = FrameWriterDropped(capture->writer);
+    if (!FrameWriterClose(capture->writer)) {
+        TraceLog(LOG_WARNING, "CAPTURE: Could not write every frame");
+    }
+    TraceLog(LOG_INFO, "CAPTURE: %i frames dropped, %i readbacks waited on the GPU", dropped, capture->stalls);
+    *capture = (FrameCapture){0};
+}
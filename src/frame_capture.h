@@ -0,0 +1,38 @@
+#ifndef PIXEL_BLOOM_FRAME_CAPTURE_H
+#define PIXEL_BLOOM_FRAME_CAPTURE_H
+
+// Records the native 160x90 frames into a video file (see frame_writer.h for
+// the formats) without stalling the GPU. Each frame is read back into the
+// next of a ring of pixel buffer objects, and the one read CAPTURE_BUFFERS - 1
+// frames ago is mapped and handed to the writer thread, by which time the
+// copy is long done. GL without pixel buffers (2.1, ES 2.0), and builds
+// against an installed raylib, which lacks the GL loader's header, read back
+// synchronously instead.
+
+#include "raylib.h"
+#include "frame_writer.h"
+
+#define CAPTURE_BUFFERS 3
+
+typedef struct FrameCapture {
+    FrameWriter *writer;    // NULL when not capturing
+    int width;
+    int height;
+    bool pixelBuffers;
+    unsigned int buffers[CAPTURE_BUFFERS];
+    void *fences[CAPTURE_BUFFERS];  // GLsync of each buffer's read
+    long long issued;       // reads started, each one into buffers[issued % CAPTURE_BUFFERS]
+    long long collected;    // reads handed to the writer
+    int stalls;             // collects that found the GPU not done yet
+} FrameCapture;
+
+// Returns false when the file can't be created
+bool FrameCaptureStart(FrameCapture *capture, const char *path, int width, int height, int fps);
+// Call after the frame is rendered into target
+void FrameCaptureTexture(FrameCapture *capture, RenderTexture2D target);
+// A frame already on the CPU, RGBA8 rows top to bottom (soft_render.h)
+void FrameCapturePixels(FrameCapture *capture, const unsigned char *pixels);
+// Writes the frames still in flight and closes the file
+void FrameCaptureStop(FrameCapture *capture);
+
+#endif // PIXEL_BLOOM_FRAME_CAPTURE_H
@@ -0,0 +1,182 @@
+#include "frame_writer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(PIXEL_BLOOM_NO_THREADS) && !defined(__STDC_NO_THREADS__)
+#include <threads.h>
+#define FRAME_WRITER_THREAD
+#endif
+
+// Frames the caller may be ahead of the file, ~130ms of 60 FPS
+#define FRAME_WRITER_SLOTS 8
+
+struct FrameWriter {
+    FILE *file;
+    bool y4m;
+    int width;
+    int height;
+    size_t frameSize;
+    uint8_t *slots;         // FRAME_WRITER_SLOTS frames of RGBA8
+    uint8_t *planes;        // Y, U and V of the frame being written, y4m only
+    long long committed;    // slots [written, committed) are queued
+    long long written;
+    int dropped;            // caller only
+    bool failed;            // writer thread only until it's joined
+#if defined(FRAME_WRITER_THREAD)
+    mtx_t lock;
+    cnd_t work;             // signaled on commit and close
+    cnd_t room;             // signaled when a slot was written
+    bool closing;
+    thrd_t thread;
+#endif
+};
+
+// BT.601 limited range in 8.8 fixed point, offset so the shifts never see a negative
+static void ConvertToPlanes(const uint8_t *rgba, uint8_t *planes, int pixels) {
+    uint8_t *y = planes;
+    uint8_t *u = planes + pixels;
+    uint8_t *v = planes + pixels * 2;
+    for (int i = 0; i < pixels; i++) {
+        const int r = rgba[i * 4];
+        const int g = rgba[i * 4 + 1];
+        const int b = rgba[i * 4 + 2];
+        y[i] = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        u[i] = (uint8_t)((-38 * r - 74 * g + 112 * b + 128 + (128 << 8)) >> 8);
+        v[i] = (uint8_t)((112 * r - 94 * g - 18 * b + 128 + (128 << 8)) >> 8);
+    }
+}
+
+static void WriteFrame(FrameWriter *writer, const uint8_t *rgba) {
+    bool ok;
+    if (writer->y4m) {
+        const int pixels = writer->width * writer->height;
+        ConvertToPlanes(rgba, writer->planes, pixels);
+        ok = fputs("FRAME\n", writer->file) >= 0 && fwrite(writer->planes, (size_t)pixels * 3, 1, writer->file) == 1;
+    } else {
+        ok = fwrite(rgba, writer->frameSize, 1, writer->file) == 1;
+    }
+    if (!ok) writer->failed = true;
+}
+
+static uint8_t *Slot(FrameWriter *writer, long long frame) {
+    return writer->slots + (size_t)(frame % FRAME_WRITER_SLOTS) * writer->frameSize;
+}
+
+#if defined(FRAME_WRITER_THREAD)
+static int WriterMain(void *data) {
+    FrameWriter *writer = data;
+    mtx_lock(&writer->lock);
+    for (;;) {
+        while (writer->written == writer->committed && !writer->closing) {
+            cnd_wait(&writer->work, &writer->lock);
+        }
+        if (writer->written == writer->committed) break;
+        const long long frame = writer->written;
+        // The caller only fills slots past committed, so this one is ours unlocked
+        mtx_unlock(&writer->lock);
+        WriteFrame(writer, Slot(writer, frame));
+        mtx_lock(&writer->lock);
+        writer->written = frame + 1;
+        cnd_signal(&writer->room);
+    }
+    mtx_unlock(&writer->lock);
+    return 0;
+}
+#endif
+
+FrameWriter *FrameWriterOpen(const char *path, int width, int height, int fps) {
+    if (width <= 0 || height <= 0) return NULL;
+    FrameWriter *writer = calloc(1, sizeof(FrameWriter));
+    if (writer == NULL) return NULL;
+    const size_t length = strlen(path);
+    writer->y4m = length >= 4 && strcmp(path + length - 4, ".y4m") == 0;
+    writer->width = width;
+    writer->height = height;
+    writer->frameSize = (size_t)width * height * 4;
+    writer->slots = malloc(writer->frameSize * FRAME_WRITER_SLOTS);
+    writer->planes = writer->y4m ? malloc((size_t)width * height * 3) : NULL;
+    writer->file = fopen(path, "wb");
+    if (writer->slots == NULL || (writer->y4m && writer->planes == NULL) || writer->file == NULL) {
+        if (writer->file != NULL) fclose(writer->file);
+        free(writer->slots);
+        free(writer->planes);
+        free(writer);
+        return NULL;
+    }
+    if (writer->y4m) {
+        fprintf(writer->file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, fps > 0 ? fps : 60);
+    }
+#if defined(FRAME_WRITER_THREAD)
+    mtx_init(&writer->lock, mtx_plain);
+    cnd_init(&writer->work);
+    cnd_init(&writer->room);
+    if (thrd_create(&writer->thread, WriterMain, writer) != thrd_success) {
+        cnd_destroy(&writer->room);
+        cnd_destroy(&writer->work);
+        mtx_destroy(&writer->lock);
+        fclose(writer->file);
+        free(writer->slots);
+        free(writer->planes);
+        free(writer);
+        return NULL;
+    }
+#endif
+    return writer;
+}
+
+uint8_t *FrameWriterBegin(FrameWriter *writer, bool wait) {
+#if defined(FRAME_WRITER_THREAD)
+    mtx_lock(&writer->lock);
+    while (wait && writer->committed - writer->written == FRAME_WRITER_SLOTS) {
+        cnd_wait(&writer->room, &writer->lock);
+    }
+    const bool full = writer->committed - writer->written == FRAME_WRITER_SLOTS;
+    mtx_unlock(&writer->lock);
+    if (full) {
+        writer->dropped++;
+        return NULL;
+    }
+#else
+    (void)wait;
+#endif
+    return Slot(writer, writer->committed);
+}
+
+void FrameWriterCommit(FrameWriter *writer) {
+#if defined(FRAME_WRITER_THREAD)
+    mtx_lock(&writer->lock);
+    writer->committed++;
+    cnd_signal(&writer->work);
+    mtx_unlock(&writer->lock);
+#else
+    WriteFrame(writer, Slot(writer, writer->committed));
+    writer->committed++;
+    writer->written++;
+#endif
+}
+
+int FrameWriterDropped(const FrameWriter *writer) {
+    return writer->dropped;
+}
+
+bool FrameWriterClose(FrameWriter *writer) {
+    if (writer == NULL) return false;
+#if defined(FRAME_WRITER_THREAD)
+    mtx_lock(&writer->lock);
+    writer->closing = true;
+    cnd_signal(&writer->work);
+    mtx_unlock(&writer->lock);
+    thrd_join(writer->thread, NULL);
+    cnd_destroy(&writer->room);
+    cnd_destroy(&writer->work);
+    mtx_destroy(&writer->lock);
+#endif
+    const bool closed = fclose(writer->file) == 0;
+    const bool ok = closed && !writer->failed;
+    free(writer->slots);
+    free(writer->planes);
+    free(writer);
+    return ok;
+}
@@ -0,0 +1,31 @@
+#ifndef PIXEL_BLOOM_FRAME_WRITER_H
+#define PIXEL_BLOOM_FRAME_WRITER_H
+
+// Streams RGBA8 frames into a video file on its own thread. The caller fills
+// a slot of a small ring and commits it; the writer thread converts and
+// writes the slots in order, so a frame costs the caller one copy.
+//
+// A path ending in .y4m gets a YUV4MPEG2 stream (4:4:4, any player or ffmpeg
+// reads it), anything else raw RGBA frames back to back
+// (ffmpeg -f rawvideo -pix_fmt rgba -s WxH).
+//
+// Without C11 threads every commit writes the frame before it returns.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct FrameWriter FrameWriter;
+
+// Returns NULL when the file can't be created or out of memory
+FrameWriter *FrameWriterOpen(const char *path, int width, int height, int fps);
+// The next free slot, width * height * 4 bytes with rows top to bottom. When
+// the writer is behind, wait blocks until a slot frees up and otherwise the
+// frame is dropped: NULL, and counted by FrameWriterDropped
+uint8_t *FrameWriterBegin(FrameWriter *writer, bool wait);
+// Queues the slot from the last FrameWriterBegin
+void FrameWriterCommit(FrameWriter *writer);
+int FrameWriterDropped(const FrameWriter *writer);
+// Writes the queued frames and closes the file. Returns false when any write failed
+bool FrameWriterClose(FrameWriter *writer);
+
+#endif // PIXEL_BLOOM_FRAME_WRITER_H
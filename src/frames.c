@@ -0,0 +1,218 @@
+// pixel-bloom-frames: plays one session through SimStep like
+// pixel-bloom-headless and writes every Nth tick's native frame as a PPM, drawn
+// by the software renderer (src/soft_render.h). No window or GL, so CI can
+// render a recorded input log and diff the frames against golden images.
+// With --video the frames go into a video file instead (src/frame_writer.h),
+// as fast as the CPU renders them. With --snapshot it draws the one tick in a
+// dump the game wrote on F9 (src/snapshot.h) instead of playing a session.
+
+#include "sim.h"
+#include "input_log.h"
+#include "policy.h"
+#include "soft_render.h"
+#include "frame_writer.h"
+#include "snapshot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct FramesOptions {
+    int capacity;
+    int every;              // ticks between written frames
+    float delta;
+    float maxSeconds;
+    uint64_t seed;
+    const char *outputDir;  // PPM per frame, NULL for none
+    const char *videoPath;  // NULL for none
+    const char *replayPath; // input log to play back, NULL for the policy
+    const char *snapshotPath; // snapshot dump to draw, NULL for a session
+    bool weatherField;      // wind and rain on a grid instead of particles
+    Policy policy;
+} FramesOptions;
+
+static void PrintUsage(const char *program) {
+    printf("usage: %s --out DIR|--video FILE.y4m [--every TICKS] [--capacity PARTICLES] [--dt SECONDS] [--max-seconds SECONDS] [--seed N] [--weather particles|field] [--policy idle|bot|cycle:SECONDS] [--replay FILE] [--snapshot FILE]\n", program);
+}
+
+static bool ParseOptions(int argc, char **argv, FramesOptions *options) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--help") == 0) {
+            return false;
+        }
+        if (value == NULL) {
+            fprintf(stderr, "missing value for %s\n", arg);
+            return false;
+        }
+        if (strcmp(arg, "--out") == 0) {
+            options->outputDir = value;
+        } else if (strcmp(arg, "--video") == 0) {
+            options->videoPath = value;
+        } else if (strcmp(arg, "--every") == 0) {
+            options->every = atoi(value);
+        } else if (strcmp(arg, "--capacity") == 0) {
+            options->capacity = atoi(value);
+        } else if (strcmp(arg, "--dt") == 0) {
+            options->delta = (float)atof(value);
+        } else if (strcmp(arg, "--max-seconds") == 0) {
+            options->maxSeconds = (float)atof(value);
+        } else if (strcmp(arg, "--seed") == 0) {
+            options->seed = strtoull(value, NULL, 10);
+        } else if (strcmp(arg, "--weather") == 0) {
+            if (strcmp(value, "field") != 0 && strcmp(value, "particles") != 0) {
+                fprintf(stderr, "unknown weather %s\n", value);
+                return false;
+            }
+            options->weatherField = strcmp(value, "field") == 0;
+        } else if (strcmp(arg, "--replay") == 0) {
+            options->replayPath = value;
+        } else if (strcmp(arg, "--snapshot") == 0) {
+            options->snapshotPath = value;
+        } else if (strcmp(arg, "--policy") == 0) {
+            if (!PolicyParse(value, &options->policy)) {
+                fprintf(stderr, "unknown policy %s\n", value);
+                return false;
+            }
+        } else {
+            fprintf(stderr, "unknown option %s\n", arg);
+            return false;
+        }
+        i++;
+    }
+    return (options->outputDir != NULL || options->videoPath != NULL) && options->every > 0 && options->capacity > 0 && options->delta > 0 && options->maxSeconds > 0;
+}
+
+static bool WriteFrame(SoftFrame *frame, const Game *game, const FramesOptions *options, FrameWriter *video, long long tick) {
+    SoftRenderFrame(frame, game, 0, true);
+    if (video != NULL) {
+        // Waits for the writer rather than drop, the file gets every frame
+        uint8_t *slot = FrameWriterBegin(video, true);
+        memcpy(slot, frame->pixels, sizeof(frame->pixels));
+        FrameWriterCommit(video);
+    }
+    if (options->outputDir == NULL) return true;
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/frame_%06lld.ppm", options->outputDir, tick);
+    if (SoftFrameWritePPM(frame, path)) return true;
+    fprintf(stderr, "can't write %s\n", path);
+    return false;
+}
+
+int main(int argc, char **argv) {
+    FramesOptions options = {
+        .capacity = DEFAULT_WIND_CAPACITY,
+        .every = 60,
+        .delta = PHYSICS_TIME,
+        .maxSeconds = 60,
+        .seed = 1,
+        .policy = { PolicyBot, 0 },
+    };
+    if (!ParseOptions(argc, argv, &options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    InputLog log = {0};
+    int windCapacity = options.capacity;
+    int waterCapacity = options.capacity;
+    if (options.replayPath != NULL) {
+        if (!InputLogLoad(&log, options.replayPath)) {
+            fprintf(stderr, "can't load input log %s\n", options.replayPath);
+            return 1;
+        }
+        windCapacity = log.windCapacity;
+        waterCapacity = log.waterCapacity;
+        options.weatherField = log.weatherField;
+    }
+
+    Game *game = calloc(1, sizeof(Game));
+    SoftFrame *frame = malloc(sizeof(SoftFrame));
+    if (game == NULL || frame == NULL) return 1;
+    if (options.weatherField) {
+        if (!SimInitWeatherField(game)) {
+            fprintf(stderr, "can't allocate the weather field\n");
+            return 1;
+        }
+    } else if (!SimInit(game, windCapacity, waterCapacity)) {
+        fprintf(stderr, "can't allocate %d particles\n", windCapacity + waterCapacity);
+        return 1;
+    }
+    SimSeed(game, options.seed);
+    // The frames only depend on the sim, which is deterministic on any thread count
+    game->jobs = JobSystemCreate(0);
+
+    FrameWriter *video = NULL;
+    if (options.videoPath != NULL) {
+        const int fps = (int)(1 / (options.delta * options.every) + 0.5f);
+        video = FrameWriterOpen(options.videoPath, NATIVE_WIDTH, NATIVE_HEIGHT, fps > 0 ? fps : 1);
+        if (video == NULL) {
+            fprintf(stderr, "can't create %s\n", options.videoPath);
+            return 1;
+        }
+    }
+
+    SimReset(game);
+    game->state = StateInGame;
+    if (options.snapshotPath != NULL) {
+        // Laid out like the game's: default capacities, the weather from --weather
+        long long snapshotTick = 0;
+        bool failed = !SnapshotLoad(options.snapshotPath, game, &snapshotTick);
+        if (failed) {
+            fprintf(stderr, "can't load snapshot %s, or it was taken with other capacities or weather\n", options.snapshotPath);
+        } else {
+            failed = !WriteFrame(frame, game, &options, video, snapshotTick);
+            printf("tick:   %lld\n", snapshotTick);
+        }
+        if (video != NULL && !FrameWriterClose(video)) failed = true;
+        JobSystemDestroy(game->jobs);
+        SimFree(game);
+        free(game);
+        free(frame);
+        return failed ? 1 : 0;
+    }
+    if (options.replayPath != NULL) {
+        InputLogStart(&log, game);
+    }
+    const long long maxTicks = (long long)(options.maxSeconds / options.delta);
+    long long tick = 0;
+    int written = 0;
+    bool failed = false;
+    while (game->state == StateInGame && (options.replayPath != NULL || tick < maxTicks)) {
+        if (tick % options.every == 0) {
+            if (!WriteFrame(frame, game, &options, video, tick)) {
+                failed = true;
+                break;
+            }
+            written++;
+        }
+        Input input = {0};
+        float delta = options.delta;
+        if (options.replayPath != NULL) {
+            if (!InputLogPlay(&log, game, &input, &delta)) break;
+        } else {
+            input = PolicyInput(options.policy, game, tick, delta);
+        }
+        SimStep(game, input, delta);
+        tick++;
+    }
+    // The last tick too, it shows how the session ended
+    if (!failed && tick % options.every != 0) {
+        failed = !WriteFrame(frame, game, &options, video, tick);
+        written += !failed;
+    }
+    printf("ticks:  %lld\n", tick);
+    if (video != NULL && !FrameWriterClose(video)) {
+        fprintf(stderr, "can't write %s\n", options.videoPath);
+        failed = true;
+    }
+    printf("frames: %d\n", written);
+
+    InputLogFree(&log);
+    JobSystemDestroy(game->jobs);
+    SimFree(game);
+    free(game);
+    free(frame);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+#include "garden.h"
+#include "sim.h"
+
+#include <stdlib.h>
+
+static const float FLOWER_START_WATER_LEVEL = 120;
+static const float FLOWER_MAX_HEALTH = 100;
+
+bool GardenInit(Garden *garden, int count) {
+    *garden = (Garden){0};
+    if (count <= 0) return false;
+    garden->waterLevel = malloc(sizeof(float) * count);
+    garden->health = malloc(sizeof(float) * count);
+    garden->frameTimer = malloc(sizeof(float) * count);
+    garden->currentFrame = malloc(sizeof(uint8_t) * count);
+    garden->isAlive = malloc(sizeof(uint8_t) * count);
+    if (garden->waterLevel == NULL || garden->health == NULL || garden->frameTimer == NULL ||
+        garden->currentFrame == NULL || garden->isAlive == NULL) {
+        GardenFree(garden);
+        return false;
+    }
+    // Fewest columns that make the garden at least 16:9
+    int columns = 1;
+    while (columns < count &&
+        (long long)columns * columns * 9 * GARDEN_PLOT_WIDTH < (long long)count * 16 * GARDEN_PLOT_HEIGHT) {
+        columns++;
+    }
+    garden->count = count;
+    garden->columns = columns;
+    garden->rows = (count + columns - 1) / columns;
+    GardenReset(garden);
+    return true;
+}
+
+void GardenFree(Garden *garden) {
+    free(garden->waterLevel);
+    free(garden->health);
+    free(garden->frameTimer);
+    free(garden->currentFrame);
+    free(garden->isAlive);
+    *garden = (Garden){0};
+}
+
+void GardenReset(Garden *garden) {
+    for (int i = 0; i < garden->count; i++) {
+        garden->waterLevel[i] = FLOWER_START_WATER_LEVEL;
+        garden->health[i] = FLOWER_MAX_HEALTH;
+        garden->currentFrame[i] = (uint8_t)(i % FLOWER_FRAMES);
+        garden->frameTimer[i] = FLOWER_FRAME_SPEED * (float)(i % 5) / 5;
+        garden->isAlive[i] = 1;
+    }
+    garden->aliveCount = garden->count;
+    garden->meanHealth = FLOWER_MAX_HEALTH;
+    garden->meanWaterLevel = FLOWER_START_WATER_LEVEL;
+}
+
+float GardenWidth(const Garden *garden) {
+    return (float)(garden->columns * GARDEN_PLOT_WIDTH);
+}
+
+float GardenHeight(const Garden *garden) {
+    return (float)(garden->rows * GARDEN_PLOT_HEIGHT);
+}
+
+int GardenFlowerAt(const Garden *garden, float x, float y) {
+    if (x < 0 || y < 0) return -1;
+    const int column = (int)(x / GARDEN_PLOT_WIDTH);
+    const int row = (int)(y / GARDEN_PLOT_HEIGHT);
+    if (column >= garden->columns) return -1;
+    const int flower = row * garden->columns + column;
+    return flower < garden->count ? flower : -1;
+}
+
+static void Kill(Garden *garden, int flower) {
+    garden->health[flower] = 0;
+    garden->isAlive[flower] = 0;
+    garden->aliveCount -= 1;
+}
+
+// One pass per field. Dead flowers go through the arithmetic too, masked out,
+// which keeps the first two loops free of branches
+int GardenGrow(Garden *garden, bool isSunUp, float drainSpeed, float dehidrationDamage, float delta) {
+    const int count = garden->count;
+    float *timer = garden->frameTimer;
+    uint8_t *frame = garden->currentFrame;
+    const uint8_t *alive = garden->isAlive;
+    for (int i = 0; i < count; i++) {
+        const float next = timer[i] + delta * alive[i];
+        const bool advance = next >= FLOWER_FRAME_SPEED;
+        timer[i] = advance ? 0 : next;
+        const uint8_t nextFrame = (uint8_t)(frame[i] + advance);
+        frame[i] = nextFrame >= FLOWER_FRAMES ? 0 : nextFrame;
+    }
+
+    float *water = garden->waterLevel;
+    float *health = garden->health;
+    const float drain = isSunUp ? drainSpeed * delta : 0;
+    const float damage = dehidrationDamage * delta;
+    float totalHealth = 0;
+    float totalWater = 0;
+    for (int i = 0; i < count; i++) {
+        const float level = water[i] - drain * alive[i];
+        const bool dry = level <= 0;
+        water[i] = dry ? 0 : level;
+        health[i] -= dry ? damage * alive[i] : 0;
+        totalHealth += health[i];
+        totalWater += water[i] * alive[i];
+    }
+
+    int deaths = 0;
+    for (int i = 0; i < count; i++) {
+        if (alive[i] && health[i] <= 0) {
+            totalHealth -= health[i];
+            Kill(garden, i);
+            deaths++;
+        }
+    }
+    garden->meanHealth = totalHealth / count;
+    garden->meanWaterLevel = garden->aliveCount > 0 ? totalWater / garden->aliveCount : 0;
+    return deaths;
+}
+
+bool GardenDamage(Garden *garden, int flower, float damage) {
+    if (flower < 0 || !garden->isAlive[flower]) return false;
+    garden->health[flower] -= damage;
+    if (garden->health[flower] > 0) return false;
+    Kill(garden, flower);
+    return true;
+}
+
+bool GardenWater(Garden *garden, int flower, float water, float tooMuchWaterDamage) {
+    if (flower < 0 || !garden->isAlive[flower]) return false;
+    garden->waterLevel[flower] += water;
+    if (garden->waterLevel[flower] > FLOWER_MAX_WATER_LEVEL) {
+        garden->waterLevel[flower] = FLOWER_MAX_WATER_LEVEL;
+        return GardenDamage(garden, flower, tooMuchWaterDamage);
+    }
+    garden->health[flower] += 1;
+    if (garden->health[flower] > FLOWER_MAX_HEALTH) {
+        garden->health[flower] = FLOWER_MAX_HEALTH;
+    }
+    return false;
+}
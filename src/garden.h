@@ -0,0 +1,58 @@
+#ifndef PIXEL_BLOOM_GARDEN_H
+#define PIXEL_BLOOM_GARDEN_H
+
+// Garden mode: thousands of flowers in one Game instead of its single Flower.
+// Each flower owns a plot, GARDEN_PLOT_WIDTH x GARDEN_PLOT_HEIGHT, laid out
+// in rows, and every plot is a small copy of the native scene: wind blows in
+// from its left edge, rain falls on it from its top. The flower state is one
+// array per field, so a tick walks each field in one tight loop.
+//
+// Particles keep plain garden coordinates. What they hit is found from the
+// position alone: the ground tests run on the position within the plot
+// (ParticlesClassifyTiled), and the flower is the plot the position is in.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Room for the wind in front of a flower sprite, and as tall as the native scene
+#define GARDEN_PLOT_WIDTH 48
+#define GARDEN_PLOT_HEIGHT 90
+// Within a plot: where the flower is drawn, and where wind and water reach it
+#define GARDEN_FLOWER_X 16
+#define GARDEN_FLOWER_LINE 31
+#define GARDEN_GROUND_LEVEL 75
+// Particle capacity per flower, enough for a plot's rain in flight
+#define GARDEN_PARTICLES_PER_FLOWER 16
+
+typedef struct Garden {
+    float *waterLevel;
+    float *health;
+    float *frameTimer;
+    uint8_t *currentFrame;
+    uint8_t *isAlive;
+    int count;          // flowers planted, 0 outside garden mode
+    int columns;        // plots per row
+    int rows;
+    int aliveCount;
+    float meanHealth;       // of every planted flower, dead ones count as 0
+    float meanWaterLevel;   // of the living ones
+} Garden;
+
+// Plants count flowers in rows, about 16:9 overall. Returns false when out of memory
+bool GardenInit(Garden *garden, int count);
+void GardenFree(Garden *garden);
+// Every flower back to a fresh one, the animations staggered so they don't
+// all sway in step
+void GardenReset(Garden *garden);
+float GardenWidth(const Garden *garden);
+float GardenHeight(const Garden *garden);
+// Flower whose plot holds the point, -1 outside the garden
+int GardenFlowerAt(const Garden *garden, float x, float y);
+// Animates, drains and dries out every living flower in a batch, and updates
+// the means. Returns how many died of dehidration
+int GardenGrow(Garden *garden, bool isSunUp, float drainSpeed, float dehidrationDamage, float delta);
+// Both return true when the flower died of it, flower -1 is ignored
+bool GardenDamage(Garden *garden, int flower, float damage);
+bool GardenWater(Garden *garden, int flower, float water, float tooMuchWaterDamage);
+
+#endif // PIXEL_BLOOM_GARDEN_H
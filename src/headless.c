@@ -0,0 +1,243 @@
+// pixel-bloom-headless: runs game sessions back to back through SimStep with
+// no window, audio or vsync, as fast as the CPU allows. With --replay every
+// session plays back a recorded input log instead of a policy, which makes a
+// reported session a repeatable benchmark.
+
+#include "sim.h"
+#include "input_log.h"
+#include "policy.h"
+#include "profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct HeadlessOptions {
+    int sessions;
+    int capacity;
+    int flowers;            // garden mode with this many flowers, 0 for the single flower
+    bool weatherField;      // wind and rain on a grid instead of particles
+    float delta;
+    float maxSeconds;
+    uint64_t seed;
+    int threads;
+    const char *tracePath;  // Chrome trace of the last ticks, NULL for none
+    const char *recordPath; // input log of the first session, NULL for none
+    const char *replayPath; // input log every session plays back, NULL for the policy
+    Policy policy;
+} HeadlessOptions;
+
+static double WallSeconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void PrintUsage(const char *program) {
+    printf("usage: %s [--sessions N] [--capacity PARTICLES] [--garden FLOWERS] [--weather particles|field] [--dt SECONDS] [--max-seconds SECONDS] [--seed N] [--threads N] [--trace FILE.json] [--policy idle|bot|cycle:SECONDS] [--record FILE] [--replay FILE]\n", program);
+}
+
+static bool ParseOptions(int argc, char **argv, HeadlessOptions *options) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--help") == 0) {
+            return false;
+        }
+        if (value == NULL) {
+            fprintf(stderr, "missing value for %s\n", arg);
+            return false;
+        }
+        if (strcmp(arg, "--sessions") == 0) {
+            options->sessions = atoi(value);
+        } else if (strcmp(arg, "--capacity") == 0) {
+            options->capacity = atoi(value);
+        } else if (strcmp(arg, "--garden") == 0) {
+            options->flowers = atoi(value);
+        } else if (strcmp(arg, "--weather") == 0) {
+            if (strcmp(value, "field") != 0 && strcmp(value, "particles") != 0) {
+                fprintf(stderr, "unknown weather %s\n", value);
+                return false;
+            }
+            options->weatherField = strcmp(value, "field") == 0;
+        } else if (strcmp(arg, "--dt") == 0) {
+            options->delta = (float)atof(value);
+        } else if (strcmp(arg, "--max-seconds") == 0) {
+            options->maxSeconds = (float)atof(value);
+        } else if (strcmp(arg, "--seed") == 0) {
+            options->seed = strtoull(value, NULL, 10);
+        } else if (strcmp(arg, "--threads") == 0) {
+            options->threads = atoi(value);
+        } else if (strcmp(arg, "--trace") == 0) {
+            options->tracePath = value;
+        } else if (strcmp(arg, "--record") == 0) {
+            options->recordPath = value;
+        } else if (strcmp(arg, "--replay") == 0) {
+            options->replayPath = value;
+        } else if (strcmp(arg, "--policy") == 0) {
+            if (!PolicyParse(value, &options->policy)) {
+                fprintf(stderr, "unknown policy %s\n", value);
+                return false;
+            }
+        } else {
+            fprintf(stderr, "unknown option %s\n", arg);
+            return false;
+        }
+        i++;
+    }
+    return options->sessions > 0 && options->capacity > 0 && options->flowers >= 0 && options->delta > 0 && options->maxSeconds > 0;
+}
+
+int main(int argc, char **argv) {
+    HeadlessOptions options = {
+        .sessions = 1000,
+        .capacity = DEFAULT_WIND_CAPACITY,
+        .delta = PHYSICS_TIME,
+        .maxSeconds = 600,
+        .seed = 1,
+        .policy = { PolicyBot, 0 },
+    };
+    if (!ParseOptions(argc, argv, &options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    InputLog log = {0};
+    int windCapacity = options.capacity;
+    int waterCapacity = options.capacity;
+    if (options.replayPath != NULL) {
+        if (!InputLogLoad(&log, options.replayPath)) {
+            fprintf(stderr, "can't load input log %s\n", options.replayPath);
+            return 1;
+        }
+        // The recorded session overflows its stores where it did before
+        windCapacity = log.windCapacity;
+        waterCapacity = log.waterCapacity;
+        options.weatherField = log.weatherField;
+    }
+
+    Game *game = calloc(1, sizeof(Game));
+    if (game == NULL) return 1;
+    if (options.weatherField) {
+        // The field covers the native scene only, and has no capacity
+        if (options.flowers > 0) {
+            fprintf(stderr, "field weather has no garden mode\n");
+            return 1;
+        }
+        if (!SimInitWeatherField(game)) {
+            fprintf(stderr, "can't allocate the weather field\n");
+            return 1;
+        }
+    } else if (options.flowers > 0) {
+        // The garden sizes its stores, --capacity doesn't apply
+        if (!SimInitGarden(game, options.flowers)) {
+            fprintf(stderr, "can't allocate a garden of %d flowers\n", options.flowers);
+            return 1;
+        }
+    } else if (!SimInit(game, windCapacity, waterCapacity)) {
+        fprintf(stderr, "can't allocate %d particles\n", windCapacity + waterCapacity);
+        return 1;
+    }
+    SimSeed(game, options.seed);
+    // 0 threads means every hardware thread
+    game->jobs = JobSystemCreate(options.threads);
+
+    const long long maxTicks = (long long)(options.maxSeconds / options.delta);
+    long long totalTicks = 0;
+    long long lastTicks = 0;
+    double totalSurvival = 0;
+    double totalScore = 0;
+    double highestScore = 0;
+    int deaths[DrawningDamage + 1] = {0};
+
+    ProfilerSetEnabled(options.tracePath != NULL);
+    const double start = WallSeconds();
+    for (int session = 0; session < options.sessions; session++) {
+        SimReset(game);
+        game->state = StateInGame;
+        const bool recording = options.recordPath != NULL && options.replayPath == NULL && session == 0;
+        if (options.replayPath != NULL) {
+            InputLogStart(&log, game);
+        } else if (recording) {
+            InputLogBegin(&log, game);
+        }
+        long long tick = 0;
+        double survival = 0;
+        // A replay runs to the end of its log, whatever --max-seconds says
+        while (game->state == StateInGame && (options.replayPath != NULL || tick < maxTicks)) {
+            Input input = {0};
+            float delta = options.delta;
+            if (options.replayPath != NULL) {
+                if (!InputLogPlay(&log, game, &input, &delta)) break;
+            } else {
+                input = PolicyInput(options.policy, game, tick, delta);
+                if (recording && !InputLogRecord(&log, game, input, delta)) {
+                    fprintf(stderr, "out of memory recording the input log\n");
+                    return 1;
+                }
+            }
+            SimStep(game, input, delta);
+            ProfilerFrameEnd();
+            survival += delta;
+            tick++;
+        }
+        if (recording && !InputLogSave(&log, game, options.recordPath)) {
+            fprintf(stderr, "can't write %s\n", options.recordPath);
+        }
+        lastTicks = tick;
+        totalTicks += tick;
+        totalSurvival += survival;
+        totalScore += game->score;
+        // Sessions still alive at the limit never reach GameOver, which is all
+        // that updates game->highestScore
+        if (game->score > highestScore) highestScore = game->score;
+        deaths[game->gameOverType] += 1;
+    }
+    const double elapsed = WallSeconds() - start;
+
+    printf("sessions:        %d\n", options.sessions);
+    printf("threads:         %d\n", JobsThreadCount(game->jobs));
+    if (options.flowers > 0) {
+        printf("garden:          %d flowers, %dx%d plots\n", game->garden.count, game->garden.columns, game->garden.rows);
+    }
+    printf("weather:         %s\n", options.weatherField ? "field" : "particles");
+    printf("ticks:           %lld\n", totalTicks);
+    printf("wall time:       %.3f s\n", elapsed);
+    printf("ticks/s:         %.0f\n", elapsed > 0 ? totalTicks / elapsed : 0.0);
+    printf("speedup vs 60Hz: %.0fx\n", elapsed > 0 ? (totalTicks / elapsed) / 60.0 : 0.0);
+    printf("mean survival:   %.2f s\n", totalSurvival / options.sessions);
+    printf("mean score:      %.2f\n", totalScore / options.sessions);
+    printf("highest score:   %.2f\n", highestScore);
+    printf("alive at limit:  %d\n", deaths[NoneDamage]);
+    printf("dehidration:     %d\n", deaths[DehidrationDamage]);
+    printf("wind:            %d\n", deaths[WindDamage]);
+    printf("drawning:        %d\n", deaths[DrawningDamage]);
+    if (options.replayPath != NULL) {
+        // Bit for bit, anything else means the sim stopped being deterministic
+        const bool matches = lastTicks == log.tickCount && game->score == log.finalScore &&
+            game->gameOverType == log.gameOverType;
+        printf("replay ticks:    %lld of %d\n", lastTicks, log.tickCount);
+        printf("replay score:    %.4f (recorded %.4f)\n", game->score, log.finalScore);
+        printf("replay matches:  %s\n", matches ? "yes" : "NO");
+    }
+
+    if (options.tracePath != NULL) {
+        const ProfileStats tick = ProfilerFrameStats();
+        printf("tick ms:         p50 %.4f  p95 %.4f  p99 %.4f  max %.4f (last %d ticks)\n", tick.p50, tick.p95, tick.p99, tick.max, PROFILER_HISTORY);
+        ProfileStats phases[PROFILER_MAX_PHASES];
+        const int phaseCount = ProfilerPhaseStats(phases, PROFILER_MAX_PHASES);
+        for (int i = 0; i < phaseCount; i++) {
+            printf("  %-15s p50 %.4f  p95 %.4f  p99 %.4f  max %.4f\n", phases[i].name, phases[i].p50, phases[i].p95, phases[i].p99, phases[i].max);
+        }
+        if (!ProfilerWriteChromeTrace(options.tracePath)) {
+            fprintf(stderr, "can't write %s\n", options.tracePath);
+        }
+    }
+
+    InputLogFree(&log);
+    JobSystemDestroy(game->jobs);
+    SimFree(game);
+    free(game);
+    return 0;
+}
@@ -0,0 +1,217 @@
+#include "input_log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INPUT_LOG_HEADER_SIZE 44
+// Version 1 ended before the flags
+#define INPUT_LOG_V1_HEADER_SIZE 40
+
+// Header flags
+#define LOG_WEATHER_FIELD 0x01
+
+// Tick flags
+#define TICK_TOGGLE_WEATHER 0x01
+#define TICK_SHIELD_PRESSED 0x02
+#define TICK_SHIELD_RELEASED 0x04
+#define TICK_SKIP_INPUT 0x08
+#define TICK_POSITION 0x10
+#define TICK_DELTA 0x20
+#define TICK_EXTRA_SHIELDS 0x40
+
+// Flags byte, position, delta, extra shield count and positions
+#define TICK_MAX_SIZE (1 + 8 + 4 + 1 + 8 * (MAX_SHIELDS - 1))
+
+static void PutU32(unsigned char *bytes, uint32_t value) {
+    bytes[0] = value & 0xff;
+    bytes[1] = (value >> 8) & 0xff;
+    bytes[2] = (value >> 16) & 0xff;
+    bytes[3] = value >> 24;
+}
+
+static uint32_t GetU32(const unsigned char *bytes) {
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static void PutFloat(unsigned char *bytes, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    PutU32(bytes, bits);
+}
+
+static float GetFloat(const unsigned char *bytes) {
+    const uint32_t bits = GetU32(bytes);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Bitwise, so -0 vs 0 and NaN payloads count as changes too
+static bool SameBits(const void *a, const void *b, size_t size) {
+    return memcmp(a, b, size) == 0;
+}
+
+static bool SameExtraShields(const Input *a, const Input *b) {
+    return a->extraShieldCount == b->extraShieldCount &&
+        SameBits(a->extraShields, b->extraShields, sizeof(Vector2) * a->extraShieldCount);
+}
+
+void InputLogBegin(InputLog *log, const Game *game) {
+    log->size = 0;
+    log->cursor = 0;
+    log->tickCount = 0;
+    log->rngState = game->rngState;
+    log->windCapacity = game->wind.capacity;
+    log->waterCapacity = game->water.capacity;
+    log->weatherField = game->weather.wind != NULL;
+    log->finalScore = 0;
+    log->gameOverType = NoneDamage;
+    log->last = (Input){0};
+    log->lastDelta = 0;
+}
+
+bool InputLogRecord(InputLog *log, const Game *game, Input input, float delta) {
+    if (log->size + TICK_MAX_SIZE > log->capacity) {
+        const int capacity = log->capacity > 0 ? log->capacity * 2 : 4096;
+        unsigned char *bytes = realloc(log->bytes, capacity);
+        if (bytes == NULL) return false;
+        log->bytes = bytes;
+        log->capacity = capacity;
+    }
+    if (input.extraShieldCount < 0) input.extraShieldCount = 0;
+    if (input.extraShieldCount > MAX_SHIELDS - 1) input.extraShieldCount = MAX_SHIELDS - 1;
+
+    unsigned char *flags = &log->bytes[log->size];
+    unsigned char *out = flags + 1;
+    *flags = (input.toggleWeather ? TICK_TOGGLE_WEATHER : 0) |
+        (input.shieldPressed ? TICK_SHIELD_PRESSED : 0) |
+        (input.shieldReleased ? TICK_SHIELD_RELEASED : 0) |
+        (game->skipInput ? TICK_SKIP_INPUT : 0);
+    if (!SameBits(&input.shieldPosition, &log->last.shieldPosition, sizeof(Vector2))) {
+        *flags |= TICK_POSITION;
+        PutFloat(out, input.shieldPosition.x);
+        PutFloat(out + 4, input.shieldPosition.y);
+        out += 8;
+    }
+    if (!SameBits(&delta, &log->lastDelta, sizeof(float))) {
+        *flags |= TICK_DELTA;
+        PutFloat(out, delta);
+        out += 4;
+    }
+    if (!SameExtraShields(&input, &log->last)) {
+        *flags |= TICK_EXTRA_SHIELDS;
+        *out++ = (unsigned char)input.extraShieldCount;
+        for (int i = 0; i < input.extraShieldCount; i++) {
+            PutFloat(out, input.extraShields[i].x);
+            PutFloat(out + 4, input.extraShields[i].y);
+            out += 8;
+        }
+    }
+    log->size = (int)(out - log->bytes);
+    log->tickCount++;
+    log->last = input;
+    log->lastDelta = delta;
+    return true;
+}
+
+bool InputLogSave(InputLog *log, const Game *game, const char *path) {
+    log->finalScore = game->score;
+    log->gameOverType = game->gameOverType;
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) return false;
+    unsigned char header[INPUT_LOG_HEADER_SIZE];
+    memcpy(header, "PBIL", 4);
+    PutU32(header + 4, INPUT_LOG_VERSION);
+    PutU32(header + 8, (uint32_t)log->rngState);
+    PutU32(header + 12, (uint32_t)(log->rngState >> 32));
+    PutU32(header + 16, (uint32_t)log->windCapacity);
+    PutU32(header + 20, (uint32_t)log->waterCapacity);
+    PutU32(header + 24, (uint32_t)log->tickCount);
+    PutU32(header + 28, (uint32_t)log->size);
+    PutFloat(header + 32, log->finalScore);
+    PutU32(header + 36, (uint32_t)log->gameOverType);
+    PutU32(header + 40, log->weatherField ? LOG_WEATHER_FIELD : 0);
+    fwrite(header, 1, sizeof(header), file);
+    fwrite(log->bytes, 1, log->size, file);
+    const bool ok = ferror(file) == 0;
+    return fclose(file) == 0 && ok;
+}
+
+bool InputLogLoad(InputLog *log, const char *path) {
+    *log = (InputLog){0};
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return false;
+    unsigned char header[INPUT_LOG_HEADER_SIZE] = {0};
+    bool ok = fread(header, 1, INPUT_LOG_V1_HEADER_SIZE, file) == INPUT_LOG_V1_HEADER_SIZE &&
+        memcmp(header, "PBIL", 4) == 0 && (GetU32(header + 4) == 1 || GetU32(header + 4) == INPUT_LOG_VERSION) &&
+        GetU32(header + 28) <= INT32_MAX && GetU32(header + 24) <= INT32_MAX &&
+        GetU32(header + 36) <= DrawningDamage;
+    if (ok && GetU32(header + 4) == INPUT_LOG_VERSION) {
+        const size_t rest = INPUT_LOG_HEADER_SIZE - INPUT_LOG_V1_HEADER_SIZE;
+        ok = fread(header + INPUT_LOG_V1_HEADER_SIZE, 1, rest, file) == rest;
+    }
+    if (ok) {
+        log->rngState = GetU32(header + 8) | ((uint64_t)GetU32(header + 12) << 32);
+        log->windCapacity = (int)GetU32(header + 16);
+        log->waterCapacity = (int)GetU32(header + 20);
+        log->tickCount = (int)GetU32(header + 24);
+        log->size = (int)GetU32(header + 28);
+        log->finalScore = GetFloat(header + 32);
+        log->gameOverType = (DamageType)GetU32(header + 36);
+        log->weatherField = GetU32(header + 40) & LOG_WEATHER_FIELD;
+        log->capacity = log->size;
+        log->bytes = malloc(log->size > 0 ? log->size : 1);
+        ok = log->bytes != NULL && fread(log->bytes, 1, log->size, file) == (size_t)log->size;
+    }
+    fclose(file);
+    if (!ok) InputLogFree(log);
+    return ok;
+}
+
+void InputLogStart(InputLog *log, Game *game) {
+    game->rngState = log->rngState;
+    log->cursor = 0;
+    log->last = (Input){0};
+    log->lastDelta = 0;
+}
+
+bool InputLogPlay(InputLog *log, Game *game, Input *input, float *delta) {
+    const unsigned char *in = log->bytes + log->cursor;
+    const unsigned char *end = log->bytes + log->size;
+    if (in >= end) return false;
+    const unsigned char flags = *in++;
+    Input next = log->last;
+    next.toggleWeather = flags & TICK_TOGGLE_WEATHER;
+    next.shieldPressed = flags & TICK_SHIELD_PRESSED;
+    next.shieldReleased = flags & TICK_SHIELD_RELEASED;
+    if (flags & TICK_POSITION) {
+        if (end - in < 8) return false;
+        next.shieldPosition = (Vector2){ GetFloat(in), GetFloat(in + 4) };
+        in += 8;
+    }
+    if (flags & TICK_DELTA) {
+        if (end - in < 4) return false;
+        log->lastDelta = GetFloat(in);
+        in += 4;
+    }
+    if (flags & TICK_EXTRA_SHIELDS) {
+        if (end - in < 1 || *in > MAX_SHIELDS - 1 || end - in < 1 + 8 * *in) return false;
+        next.extraShieldCount = *in++;
+        for (int i = 0; i < next.extraShieldCount; i++) {
+            next.extraShields[i] = (Vector2){ GetFloat(in), GetFloat(in + 4) };
+            in += 8;
+        }
+    }
+    log->cursor = (int)(in - log->bytes);
+    log->last = next;
+    game->skipInput = flags & TICK_SKIP_INPUT;
+    *input = next;
+    *delta = log->lastDelta;
+    return true;
+}
+
+void InputLogFree(InputLog *log) {
+    free(log->bytes);
+    *log = (InputLog){0};
+}
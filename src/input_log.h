@@ -0,0 +1,60 @@
+#ifndef PIXEL_BLOOM_INPUT_LOG_H
+#define PIXEL_BLOOM_INPUT_LOG_H
+
+// Per-tick input of one session, enough to replay it exactly: with the RNG
+// state the session started from, the particle capacities, the weather engine
+// and every tick's Input and delta, SimStep does the same thing again on any
+// machine and any thread count. Layout, all integers little-endian:
+//
+//   "PBIL"  u32 version  u64 rngState  u32 windCapacity  u32 waterCapacity
+//   u32 tickCount  u32 byteCount  f32 finalScore  u32 gameOverType  u32 flags
+//   byteCount bytes of ticks
+//
+// flags bit 0 is field weather. Version 1 logs have no flags and load as 0
+//
+// A tick is one flags byte, followed by only what changed since the tick
+// before it: the shield position (2 x f32), the delta (f32) and the extra
+// shields (u8 count, count x 2 x f32). Floats are stored bit for bit, so a
+// steady 60Hz session with the mouse still costs one byte a tick.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sim.h"
+
+#define INPUT_LOG_VERSION 2
+
+typedef struct InputLog {
+    unsigned char *bytes;
+    int size;
+    int capacity;
+    int cursor;             // playback read position
+    int tickCount;
+    uint64_t rngState;      // Game.rngState when the session began
+    int windCapacity;
+    int waterCapacity;
+    bool weatherField;      // played with SimInitWeatherField
+    float finalScore;       // what the recorded session ended with
+    DamageType gameOverType;
+    Input last;             // previous tick, what the change flags compare against
+    float lastDelta;
+} InputLog;
+
+// Starts recording the session game is about to play, right after SimReset
+void InputLogBegin(InputLog *log, const Game *game);
+// Call before each SimStep with the same input and delta. Returns false when out of memory
+bool InputLogRecord(InputLog *log, const Game *game, Input input, float delta);
+// Stamps the session's result and writes the log, returns false when the file can't be written
+bool InputLogSave(InputLog *log, const Game *game, const char *path);
+// Returns false when the file is missing, of another version or corrupt
+bool InputLogLoad(InputLog *log, const char *path);
+// Seeds game like the recorded session and rewinds playback to its first
+// tick. SimInit must have used the log's capacities, and SimInitWeatherField
+// when the log has weatherField
+void InputLogStart(InputLog *log, Game *game);
+// Next tick's input and delta, also restores game->skipInput as recorded.
+// Returns false past the last tick
+bool InputLogPlay(InputLog *log, Game *game, Input *input, float *delta);
+void InputLogFree(InputLog *log);
+
+#endif // PIXEL_BLOOM_INPUT_LOG_H
@@ -0,0 +1,287 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // sysconf
+#endif
+
+#include "jobs.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(PIXEL_BLOOM_NO_THREADS) || defined(__STDC_NO_THREADS__)
+#define JOBS_INLINE
+#else
+#include <stdatomic.h>
+#include <threads.h>
+#endif
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__EMSCRIPTEN__)
+#include <emscripten/threading.h>
+#else
+#include <unistd.h>
+#endif
+
+int JobsHardwareThreads(void) {
+#if defined(JOBS_INLINE)
+    return 1;
+#elif defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#elif defined(__EMSCRIPTEN__)
+    return emscripten_num_logical_cores(); // navigator.hardwareConcurrency
+#else
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+static int ChunkSize(int count, int grain) {
+    if (grain < 1) grain = 1;
+    const int least = (count + JOB_MAX_CHUNKS - 1) / JOB_MAX_CHUNKS;
+    return grain > least ? grain : least;
+}
+
+int JobsChunkCount(int count, int grain) {
+    if (count <= 0) return 0;
+    const int size = ChunkSize(count, grain);
+    return (count + size - 1) / size;
+}
+
+static void RunInline(int count, int grain, JobFunction function, void *data) {
+    const int size = ChunkSize(count, grain);
+    const int chunks = JobsChunkCount(count, grain);
+    for (int chunk = 0; chunk < chunks; chunk++) {
+        const int begin = chunk * size;
+        function(data, chunk, begin, begin + size < count ? begin + size : count);
+    }
+}
+
+#if defined(JOBS_INLINE)
+
+struct JobSystem {
+    int threadCount;
+};
+
+JobSystem *JobSystemCreate(int threadCount) {
+    (void)threadCount;
+    JobSystem *jobs = malloc(sizeof(JobSystem));
+    if (jobs != NULL) jobs->threadCount = 1;
+    return jobs;
+}
+
+void JobSystemDestroy(JobSystem *jobs) {
+    free(jobs);
+}
+
+int JobsThreadCount(const JobSystem *jobs) {
+    (void)jobs;
+    return 1;
+}
+
+int JobsParallelFor(JobSystem *jobs, int count, int grain, JobFunction function, void *data) {
+    (void)jobs;
+    RunInline(count, grain, function, data);
+    return JobsChunkCount(count, grain);
+}
+
+#else
+
+// Splitting halves the range every time, so a deque never holds more than
+// log2(JOB_MAX_CHUNKS) + 1 ranges
+#define JOB_DEQUE_CAPACITY 64
+#define JOB_CACHE_LINE 64
+
+// Chase-Lev deque of chunk ranges, packed as begin << 32 | end. The owner
+// pushes and pops at the bottom, thieves take from the top.
+typedef struct JobDeque {
+    atomic_llong top;
+    char pad0[JOB_CACHE_LINE];
+    atomic_llong bottom;
+    char pad1[JOB_CACHE_LINE];
+    atomic_ullong ranges[JOB_DEQUE_CAPACITY];
+} JobDeque;
+
+typedef struct JobWorker {
+    JobSystem *jobs;
+    int index;
+    thrd_t thread;
+} JobWorker;
+
+struct JobSystem {
+    int threadCount;
+    JobDeque *deques;          // one per thread, index 0 is the caller's
+    JobWorker *workers;        // threadCount - 1 spawned threads
+    int started;
+
+    // The running JobsParallelFor, written before its first range is pushed
+    JobFunction function;
+    void *data;
+    int count;
+    int chunkSize;
+    atomic_int pending;        // chunks not finished yet
+
+    mtx_t lock;
+    cnd_t wake;
+    unsigned int generation;   // bumped once per JobsParallelFor
+    bool quit;
+};
+
+static unsigned long long PackRange(int begin, int end) {
+    return ((unsigned long long)(uint32_t)begin << 32) | (uint32_t)end;
+}
+
+static void DequePush(JobDeque *deque, unsigned long long range) {
+    const long long bottom = atomic_load(&deque->bottom);
+    atomic_store(&deque->ranges[bottom & (JOB_DEQUE_CAPACITY - 1)], range);
+    atomic_store(&deque->bottom, bottom + 1);
+}
+
+static bool DequePop(JobDeque *deque, unsigned long long *range) {
+    const long long bottom = atomic_load(&deque->bottom) - 1;
+    atomic_store(&deque->bottom, bottom);
+    long long top = atomic_load(&deque->top);
+    if (top > bottom) {
+        atomic_store(&deque->bottom, bottom + 1);
+        return false;
+    }
+    *range = atomic_load(&deque->ranges[bottom & (JOB_DEQUE_CAPACITY - 1)]);
+    if (top == bottom) {
+        // Last range: race the thieves for it
+        const bool won = atomic_compare_exchange_strong(&deque->top, &top, top + 1);
+        atomic_store(&deque->bottom, bottom + 1);
+        return won;
+    }
+    return true;
+}
+
+static bool DequeSteal(JobDeque *deque, unsigned long long *range) {
+    long long top = atomic_load(&deque->top);
+    const long long bottom = atomic_load(&deque->bottom);
+    if (top >= bottom) return false;
+    *range = atomic_load(&deque->ranges[top & (JOB_DEQUE_CAPACITY - 1)]);
+    return atomic_compare_exchange_strong(&deque->top, &top, top + 1);
+}
+
+static bool TakeRange(JobSystem *jobs, int index, unsigned long long *range) {
+    if (DequePop(&jobs->deques[index], range)) return true;
+    for (int k = 1; k < jobs->threadCount; k++) {
+        if (DequeSteal(&jobs->deques[(index + k) % jobs->threadCount], range)) return true;
+    }
+    return false;
+}
+
+static void RunRange(JobSystem *jobs, int index, unsigned long long range) {
+    do {
+        int begin = (int)(range >> 32);
+        int end = (int)(uint32_t)range;
+        // Keep the lower half, leave the upper one for whoever is idle
+        while (end - begin > 1) {
+            const int middle = begin + (end - begin) / 2;
+            DequePush(&jobs->deques[index], PackRange(middle, end));
+            end = middle;
+        }
+        const int first = begin * jobs->chunkSize;
+        const int last = first + jobs->chunkSize < jobs->count ? first + jobs->chunkSize : jobs->count;
+        jobs->function(jobs->data, begin, first, last);
+        atomic_fetch_sub(&jobs->pending, 1);
+    } while (DequePop(&jobs->deques[index], &range));
+}
+
+static void WorkUntilDone(JobSystem *jobs, int index) {
+    unsigned long long range;
+    while (atomic_load(&jobs->pending) > 0) {
+        if (TakeRange(jobs, index, &range)) {
+            RunRange(jobs, index, range);
+        } else {
+            thrd_yield();
+        }
+    }
+}
+
+static int WorkerMain(void *arg) {
+    JobWorker *worker = arg;
+    JobSystem *jobs = worker->jobs;
+    unsigned int seen = 0;
+    for (;;) {
+        mtx_lock(&jobs->lock);
+        while (jobs->generation == seen && !jobs->quit) {
+            cnd_wait(&jobs->wake, &jobs->lock);
+        }
+        seen = jobs->generation;
+        const bool quit = jobs->quit;
+        mtx_unlock(&jobs->lock);
+        if (quit) return 0;
+        WorkUntilDone(jobs, worker->index);
+    }
+}
+
+JobSystem *JobSystemCreate(int threadCount) {
+    if (threadCount <= 0) threadCount = JobsHardwareThreads();
+    JobSystem *jobs = calloc(1, sizeof(JobSystem));
+    if (jobs == NULL) return NULL;
+    jobs->threadCount = threadCount;
+    jobs->deques = calloc(threadCount, sizeof(JobDeque));
+    jobs->workers = calloc(threadCount, sizeof(JobWorker));
+    if (jobs->deques == NULL || jobs->workers == NULL) {
+        free(jobs->deques);
+        free(jobs->workers);
+        free(jobs);
+        return NULL;
+    }
+    mtx_init(&jobs->lock, mtx_plain);
+    cnd_init(&jobs->wake);
+    for (int i = 1; i < threadCount; i++) {
+        jobs->workers[i] = (JobWorker){ .jobs = jobs, .index = i };
+        if (thrd_create(&jobs->workers[i].thread, WorkerMain, &jobs->workers[i]) != thrd_success) break;
+        jobs->started = i;
+    }
+    // Whatever threads started are all the system gets
+    jobs->threadCount = jobs->started + 1;
+    return jobs;
+}
+
+void JobSystemDestroy(JobSystem *jobs) {
+    if (jobs == NULL) return;
+    mtx_lock(&jobs->lock);
+    jobs->quit = true;
+    cnd_broadcast(&jobs->wake);
+    mtx_unlock(&jobs->lock);
+    for (int i = 1; i <= jobs->started; i++) {
+        thrd_join(jobs->workers[i].thread, NULL);
+    }
+    cnd_destroy(&jobs->wake);
+    mtx_destroy(&jobs->lock);
+    free(jobs->deques);
+    free(jobs->workers);
+    free(jobs);
+}
+
+int JobsThreadCount(const JobSystem *jobs) {
+    return jobs != NULL ? jobs->threadCount : 1;
+}
+
+int JobsParallelFor(JobSystem *jobs, int count, int grain, JobFunction function, void *data) {
+    const int chunks = JobsChunkCount(count, grain);
+    if (jobs == NULL || jobs->threadCount == 1 || chunks <= 1) {
+        RunInline(count, grain, function, data);
+        return chunks;
+    }
+    jobs->function = function;
+    jobs->data = data;
+    jobs->count = count;
+    jobs->chunkSize = ChunkSize(count, grain);
+    atomic_store(&jobs->pending, chunks);
+    DequePush(&jobs->deques[0], PackRange(0, chunks));
+
+    mtx_lock(&jobs->lock);
+    jobs->generation++;
+    cnd_broadcast(&jobs->wake);
+    mtx_unlock(&jobs->lock);
+
+    WorkUntilDone(jobs, 0);
+    return chunks;
+}
+
+#endif
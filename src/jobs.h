@@ -0,0 +1,38 @@
+#ifndef PIXEL_BLOOM_JOBS_H
+#define PIXEL_BLOOM_JOBS_H
+
+// Small fork-join job system on C11 threads. JobsParallelFor cuts a range
+// into chunks whose bounds depend only on the count and the grain, never on
+// the thread count, so per-chunk results can be combined in chunk order and
+// come out the same on any machine. Every thread owns a work-stealing deque:
+// a thread splits the chunk range it holds in halves, keeps the lower half
+// and pushes the upper one, and idle threads steal the oldest (largest)
+// halves from the others.
+//
+// Without C11 threads (__STDC_NO_THREADS__, or PIXEL_BLOOM_NO_THREADS on web
+// builds without pthreads) every chunk runs inline, in order.
+
+#include <stdbool.h>
+
+// Upper bound on chunks per JobsParallelFor, the grain grows to stay under it
+#define JOB_MAX_CHUNKS 256
+
+typedef struct JobSystem JobSystem;
+
+// chunk is the index of [begin, end) in 0 .. JobsChunkCount(count, grain)
+typedef void (*JobFunction)(void *data, int chunk, int begin, int end);
+
+// threadCount <= 0 uses every hardware thread. Returns NULL when out of memory
+JobSystem *JobSystemCreate(int threadCount);
+void JobSystemDestroy(JobSystem *jobs);
+// Threads working on a JobsParallelFor, including the caller. 1 for NULL
+int JobsThreadCount(const JobSystem *jobs);
+int JobsHardwareThreads(void);
+
+int JobsChunkCount(int count, int grain);
+// Runs function over [0, count) in chunks of at least grain items and returns
+// once all of them finished. The calling thread works too. A NULL system runs
+// inline. Only one thread may call it at a time, and jobs must not call it.
+int JobsParallelFor(JobSystem *jobs, int count, int grain, JobFunction function, void *data);
+
+#endif // PIXEL_BLOOM_JOBS_H
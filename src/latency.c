@@ -0,0 +1,73 @@
+#include "latency.h"
+#include "raylib.h"
+#include "rlgl.h"
+
+#if defined(PLATFORM_DESKTOP) && defined(PIXEL_BLOOM_RAYLIB_GLAD)
+// The GL loader raylib already links in, for fences. Only a raylib built from
+// source has its header (CMakeLists.txt)
+#include "external/glad.h"
+#define LATENCY_DESKTOP
+#endif
+
+void LatencyInit(LatencyMeter *meter, int queueDepth) {
+    *meter = (LatencyMeter){0};
+    if (queueDepth > LATENCY_MAX_QUEUE) queueDepth = LATENCY_MAX_QUEUE;
+    if (queueDepth <= 0) return;
+#if defined(LATENCY_DESKTOP)
+    const int version = rlGetVersion();
+    if (version == RL_OPENGL_33 || version == RL_OPENGL_43) {
+        meter->queueDepth = queueDepth;
+        TraceLog(LOG_INFO, "LATENCY: At most %i frames queued on the GPU", queueDepth);
+        return;
+    }
+#endif
+    TraceLog(LOG_WARNING, "LATENCY: No GL fences in this build, the frame queue is up to the driver");
+}
+
+void LatencyFree(LatencyMeter *meter) {
+#if defined(LATENCY_DESKTOP)
+    for (int i = 0; i < LATENCY_MAX_QUEUE; i++) {
+        if (meter->fences[i] != NULL) glDeleteSync(meter->fences[i]);
+    }
+#endif
+    *meter = (LatencyMeter){0};
+}
+
+void LatencyWaitForQueue(LatencyMeter *meter) {
+#if defined(LATENCY_DESKTOP)
+    if (meter->queueDepth == 0) return;
+    // The fence of the frame queueDepth frames back, that slot is reused next
+    const int index = (int)(meter->frames % meter->queueDepth);
+    GLsync fence = meter->fences[index];
+    if (fence == NULL) return;
+    glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000);
+    glDeleteSync(fence);
+    meter->fences[index] = NULL;
+#else
+    (void)meter;
+#endif
+}
+
+void LatencyInputSampled(LatencyMeter *meter, uint64_t time) {
+    if (meter->pending == 0) meter->pending = time;
+}
+
+void LatencyFrameSwapped(LatencyMeter *meter) {
+#if defined(LATENCY_DESKTOP)
+    if (meter->queueDepth > 0) {
+        const int index = (int)(meter->frames % meter->queueDepth);
+        if (meter->fences[index] != NULL) glDeleteSync(meter->fences[index]);
+        meter->fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+#endif
+    meter->frames++;
+    if (meter->pending == 0) return;
+    meter->history[meter->historyNext] = (float)((ProfilerNow() - meter->pending) / 1e6);
+    meter->historyNext = (meter->historyNext + 1) % LATENCY_HISTORY;
+    if (meter->historyCount < LATENCY_HISTORY) meter->historyCount++;
+    meter->pending = 0;
+}
+
+ProfileStats LatencyStats(const LatencyMeter *meter) {
+    return ProfilerPercentiles(meter->history, meter->historyCount, "input to swap");
+}
@@ -0,0 +1,39 @@
+#ifndef PIXEL_BLOOM_LATENCY_H
+#define PIXEL_BLOOM_LATENCY_H
+
+// Input to display latency: a meter from the moment an input change is
+// sampled to the buffer swap that shows it, and a cap on how many frames the
+// GPU may queue behind the CPU. Without the cap a driver queues two or three
+// frames, and every one of them is a frame of lag on the shield.
+
+#include "profiler.h"
+
+#include <stdint.h>
+
+#define LATENCY_HISTORY 600     // samples the percentiles cover
+#define LATENCY_MAX_QUEUE 3
+
+typedef struct LatencyMeter {
+    float history[LATENCY_HISTORY];     // milliseconds, a ring
+    int historyCount;
+    int historyNext;
+    uint64_t pending;       // ProfilerNow() of the oldest change the next swap shows, 0 for none
+    int queueDepth;         // frames in flight at most, 0 leaves the driver's queue alone
+    void *fences[LATENCY_MAX_QUEUE];    // GLsync of the last frames, by frame % queueDepth
+    long long frames;
+} LatencyMeter;
+
+// depth 0 doesn't cap the queue. GL without fences (2.1, ES), or a build
+// against an installed raylib, can't cap it and logs a warning
+void LatencyInit(LatencyMeter *meter, int queueDepth);
+void LatencyFree(LatencyMeter *meter);
+// Call before sampling input: waits until the GPU is done with all but the
+// last queueDepth - 1 frames, so the input is read as late as the queue allows
+void LatencyWaitForQueue(LatencyMeter *meter);
+// A change of input was sampled at time (ProfilerNow)
+void LatencyInputSampled(LatencyMeter *meter, uint64_t time);
+// Call right after EndDrawing
+void LatencyFrameSwapped(LatencyMeter *meter);
+ProfileStats LatencyStats(const LatencyMeter *meter);
+
+#endif // PIXEL_BLOOM_LATENCY_H
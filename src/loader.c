@@ -0,0 +1,148 @@
+#include "loader.h"
+#include "profiler.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(PIXEL_BLOOM_NO_THREADS) || defined(__STDC_NO_THREADS__)
+#define LOADER_INLINE
+#else
+#include <stdatomic.h>
+#include <threads.h>
+#endif
+
+typedef struct LoadStep {
+    const char *name;
+    LoadFunction function;
+    void *data;
+    bool onMain;
+    bool ok;
+    uint64_t start;
+    uint64_t end;
+#if defined(LOADER_INLINE)
+    bool done;
+#else
+    atomic_bool done;       // release once ok and end are written
+    thrd_t thread;
+    bool started;
+#endif
+} LoadStep;
+
+struct Loader {
+    LoadStep steps[LOADER_MAX_STEPS];
+    int count;
+    int next;               // first step LoaderUpdate hasn't run or seen finish
+    uint64_t start;
+};
+
+static void RunStep(LoadStep *step) {
+    step->start = ProfilerNow();
+    step->ok = step->function(step->data);
+    step->end = ProfilerNow();
+}
+
+static bool IsDone(const LoadStep *step) {
+#if defined(LOADER_INLINE)
+    return step->done;
+#else
+    return atomic_load_explicit(&step->done, memory_order_acquire);
+#endif
+}
+
+#if !defined(LOADER_INLINE)
+static int WorkerMain(void *data) {
+    LoadStep *step = data;
+    RunStep(step);
+    atomic_store_explicit(&step->done, true, memory_order_release);
+    return 0;
+}
+#endif
+
+Loader *LoaderCreate(void) {
+    return calloc(1, sizeof(Loader));
+}
+
+bool LoaderAdd(Loader *loader, const char *name, LoadFunction function, void *data, bool onMain) {
+    if (loader->count == LOADER_MAX_STEPS) return false;
+    LoadStep *step = &loader->steps[loader->count++];
+    *step = (LoadStep){ .name = name, .function = function, .data = data, .onMain = onMain };
+    return true;
+}
+
+void LoaderStart(Loader *loader) {
+    loader->start = ProfilerNow();
+#if !defined(LOADER_INLINE)
+    for (int i = 0; i < loader->count; i++) {
+        LoadStep *step = &loader->steps[i];
+        if (step->onMain) continue;
+        step->started = thrd_create(&step->thread, WorkerMain, step) == thrd_success;
+        // No thread to spare, LoaderUpdate runs it like a main step
+        if (!step->started) step->onMain = true;
+    }
+#endif
+}
+
+bool LoaderUpdate(Loader *loader, float budgetMs) {
+    const uint64_t start = ProfilerNow();
+    const uint64_t budget = (uint64_t)(budgetMs * 1e6f);
+    bool ranOne = false;
+    // Steps finish in any order, but main steps run in the order they were added
+    for (int i = loader->next; i < loader->count; i++) {
+        LoadStep *step = &loader->steps[i];
+        if (IsDone(step)) continue;
+#if defined(LOADER_INLINE)
+        const bool runsHere = true;
+#else
+        const bool runsHere = step->onMain;
+#endif
+        if (!runsHere) continue;
+        if (ranOne && ProfilerNow() - start >= budget) break;
+        RunStep(step);
+#if defined(LOADER_INLINE)
+        step->done = true;
+#else
+        atomic_store_explicit(&step->done, true, memory_order_release);
+#endif
+        ranOne = true;
+    }
+    while (loader->next < loader->count && IsDone(&loader->steps[loader->next])) {
+        loader->next++;
+    }
+    return loader->next == loader->count;
+}
+
+float LoaderProgress(const Loader *loader) {
+    if (loader->count == 0) return 1;
+    int done = 0;
+    for (int i = 0; i < loader->count; i++) {
+        done += IsDone(&loader->steps[i]);
+    }
+    return (float)done / loader->count;
+}
+
+int LoaderStepCount(const Loader *loader) {
+    return loader->count;
+}
+
+void LoaderStepInfo(const Loader *loader, int index, LoadStepInfo *info) {
+    const LoadStep *step = &loader->steps[index];
+    const bool done = IsDone(step);
+    *info = (LoadStepInfo){
+        .name = step->name,
+        .onMain = step->onMain,
+        .done = done,
+        .ok = done && step->ok,
+        .startedAt = done ? (float)((step->start - loader->start) / 1e6) : 0,
+        .milliseconds = done ? (float)((step->end - step->start) / 1e6) : 0,
+    };
+}
+
+void LoaderDestroy(Loader *loader) {
+    if (loader == NULL) return;
+#if !defined(LOADER_INLINE)
+    for (int i = 0; i < loader->count; i++) {
+        if (loader->steps[i].started) thrd_join(loader->steps[i].thread, NULL);
+    }
+#endif
+    free(loader);
+}
@@ -0,0 +1,46 @@
+#ifndef PIXEL_BLOOM_LOADER_H
+#define PIXEL_BLOOM_LOADER_H
+
+// Startup loading in steps, so the window can draw a progress screen from the
+// first frame. Worker steps (decoding, audio, allocations) each get a thread
+// of their own and run side by side; main steps (anything touching GL) run on
+// the thread calling LoaderUpdate, a few per frame. Every step is timed.
+//
+// Without C11 threads (__STDC_NO_THREADS__, or PIXEL_BLOOM_NO_THREADS on web
+// builds) worker steps run in LoaderUpdate too, between frames.
+
+#include <stdbool.h>
+
+#define LOADER_MAX_STEPS 16
+
+// Returns false when the step failed, the loader carries on with the others
+typedef bool (*LoadFunction)(void *data);
+
+typedef struct Loader Loader;
+
+typedef struct LoadStepInfo {
+    const char *name;
+    bool onMain;
+    bool done;
+    bool ok;
+    float startedAt;        // milliseconds after LoaderStart
+    float milliseconds;     // how long the step ran
+} LoadStepInfo;
+
+// Returns NULL when out of memory
+Loader *LoaderCreate(void);
+// Steps must be added before LoaderStart. Returns false when the loader is full
+bool LoaderAdd(Loader *loader, const char *name, LoadFunction function, void *data, bool onMain);
+// Starts the worker steps
+void LoaderStart(Loader *loader);
+// Runs main steps in order until budgetMs is used up, at least one per call.
+// Returns true once every step is done
+bool LoaderUpdate(Loader *loader, float budgetMs);
+// Steps done out of all of them, 0 to 1
+float LoaderProgress(const Loader *loader);
+int LoaderStepCount(const Loader *loader);
+void LoaderStepInfo(const Loader *loader, int index, LoadStepInfo *info);
+// Waits for the workers still running
+void LoaderDestroy(Loader *loader);
+
+#endif // PIXEL_BLOOM_LOADER_H
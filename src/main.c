@@ -2,215 +2,289 @@
 #include "raylib.h"
 #include "raymath.h"
 
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
 #if defined(PLATFORM_WEB)
     #include <emscripten/emscripten.h>
+    #include <emscripten/html5.h>
 #endif
-#define MAX_WIND_PARTICLES 200
-#define MAX_WATER_PARTICLES 200
-
-
-const int NATIVE_WIDTH = 160; // e.g., 160x90 for a 16:9 aspect ratio
-const int NATIVE_HEIGHT = 90;
+#if defined(PLATFORM_DESKTOP)
+    #define IDLE_EVENT_WAITING
+#endif
+#include "sim.h"
+#include "render.h"
+#include "asset_pack.h"
+#include "profiler.h"
+#include "input_log.h"
+#include "ui.h"
+#include "background_music.h"
+#include "soft_render.h"
+#include "frame_capture.h"
+#include "latency.h"
+#include "loader.h"
+#include "snapshot.h"
 
-const float PHYSICS_TIME            = 0.02;
 const int FONT_SIZE                 = 20;
 const int LINE_DURATION = 10;
-const int DEHIDRATION_DAMAGE = 10;
-const int TOO_MUCH_WATER_DAMAGE = 10;
-const int SHIELD_RADIUS = 5;
-const int DEFAULT_BAR_HEIGHT = 40;
 // const int PLAYER_MAX_SHOOTS			= 100;
 
-// Flower consts
-const int FLOWER_FRAMES = 7;
-const float FLOWER_FRAME_SPEED  = .3;
-const float FLOWER_WATER_DRAIN_SPEED = 10;
-const float FLOWER_MAX_WATER_LEVEL = 200;
-
-// Sun consts
-const int SUN_FRAMES = 8;
-const float SUN_FRAME_SPEED  = .3;
-const float SUN_AMOUNT = 10.0;
-const float WIND_PARTICLES_CD = 1;
-
-// Cloud consts
-const int CLOUD_FRAMES = 8;
-const float CLOUD_FRAME_SPEED  = .3;
-const float CLOUD_AMOUNT = 5.0;
-const float WATER_PARTICLES_CD = .3;
-
-typedef struct Flower {
-    float frameTimer;
-    float waterLevel;
-    float health;
-    int currentFrame;
-    bool isAlive;
-    Texture2D texture;
-} Flower;
-
-typedef struct Sun {
-    float frameTimer;
-    int currentFrame;
-    int sunAmount;
-    Texture2D texture;
-} Sun;
-
-typedef struct Cloud {
-    float frameTimer;
-    int currentFrame;
-    int rainAmount;
-    Texture2D texture;
-} Cloud;
-
-typedef struct WindParticles {
-    float power;
-    Vector2 position;
-} WindParticles;
-
-typedef struct WaterParticles {
-    float amount;
-    Vector2 position;
-} WaterParticles;
-
-typedef enum GameStateType {
-    StateInGame = 1,
-    StateStartMenu = 2,
-    StateGameOver = 3,
-} GameStateType;
-
-typedef enum DamageType {
-    NoneDamage = 0,
-    DehidrationDamage = 1,
-    WindDamage = 2,
-    DrawningDamage = 3,
-} DamageType;
-
-typedef struct Game {
-    Texture2D healthTexture;
-    Texture2D waterTexture;
-    WindParticles windArray[MAX_WIND_PARTICLES];
-    WaterParticles waterArray[MAX_WATER_PARTICLES];
-    Flower flower;
-    Sun sun;
-    Cloud cloud;
-    Vector2 shieldPosition;
-	GameStateType state;
-    DamageType gameOverType;
-    int width;
-    int height;
-    float virtualRatio;
-    float score;
-    float highestScore;
-    int windArrayAmount;
-    int waterArrayAmount;
-    float windParticleCD;
-    float waterParticleCD;
-    bool isSunUp;
-    bool skipInput;
-    bool isMusicPaused;
-    bool isPaused;
-    bool isShielding;
-} Game;
-
 static Game game = {0};
+static GameTextures textures = {0};
+static ParticleRenderer particleRenderer = {0};
 
 static const float menu_size_width = 200.0f;
 static const float item_menu_size_height = 50.0f;
-static Rectangle exitMenuRec = {0};
-static Rectangle startMenuRec = {0};
-static Rectangle restartMenuRec = {0};
 static RenderTexture2D target = {0};
 
-
-static Rectangle healthRec = {0};
-static Rectangle hidrationRec = {0};
+// Laid out by PlaceUIButtons, shown per state by UpdateUIVisibility
+static UiLayer ui = {0};
+static int musicButton = -1;
+static int pauseButton = -1;
+static int continueButton = -1;
+static int startButton = -1;
+static int restartButton = -1;
+static int exitButton = -1;
+static int deathLabel = -1;
+static int highestScoreLabel = -1;
 
 // The target's height is flipped (in the source Rectangle), due to OpenGL reasons
 static Rectangle sourceRec = {0};
 static Rectangle destRec = {0};
 
-static Music music = {0};
+// --soft-render draws the native frame on the CPU (soft_render.h) and uploads
+// it as one texture, which is right side up
+static bool softRender = false;
+static SoftFrame softFrame = {0};
+static Texture2D softTexture = {0};
+
+// --capture FILE records every native frame in game, see frame_capture.h
+static const char *capturePath = NULL;
+static FrameCapture capture = {0};
+
+// --low-latency 1 draws the shields over the upscaled frame instead of into
+// the target, the mouse one at the pointer rather than the ticked position.
+// --frame-queue N caps the frames the GPU may queue. The meter runs either way
+static bool lowLatency = false;
+static int frameQueue = 0;
+static LatencyMeter latency = {0};
+static Vector2 lastPointer = {0};
+
+// --garden FLOWERS plays garden mode, drawn straight to the screen through a
+// camera that fits the whole garden, with the score on a label
+static int gardenFlowers = 0;
+static Camera2D gardenCamera = {0};
+static int gardenLabel = -1;
+static int shownGardenScore = -1;
+static int shownAliveCount = -1;
+
+// --weather field blows wind and rain through a grid instead of particles
+static bool weatherField = false;
+
+static AssetPack assets = {0};
+static AssetBlob musicBlob = {0};  // decoded straight from the pack mapping
 
 static bool isPlaying = true;
 
- 
-int MenuButtom(Rectangle buttom, const char *buttom_text) {
-    if (IsMouseButtonReleased(MOUSE_LEFT_BUTTON) && CheckCollisionPointRec(GetMousePosition(), buttom))
-    {
-        game.skipInput = true;
-        return true;
-    }
-    DrawRectangleRec(buttom, GRAY);
+// Startup goes through a Loader (loader.h): the window shows a progress bar
+// from its first frame while the audio and the sim load on worker threads and
+// the GL uploads run between frames
+#define LOADING_BUDGET_MS 8
+static Loader *loader = NULL;
+static uint64_t launchTime = 0;
+static bool firstFrameShown = false;
+static const char *replayPath = NULL;
+static bool showProfiler = false;   // F3, also turns the profiler on
+
+// The sim ticks at a fixed --tick-rate, whatever the frame rate. Frames in
+// between draw the particles interpolated from the last two ticks
+#define MAX_CATCH_UP_TICKS 5
+static float tickDelta = PHYSICS_TIME;
+static float accumulator = 0;       // frame time the ticks haven't consumed yet
+static Input pendingInput = {0};    // what the frames since the last tick read
+
+// --record FILE keeps the latest session's input there, --replay FILE plays one back
+static InputLog inputLog = {0};
+static const char *recordPath = NULL;
+static bool isRecording = false;
+static bool isReplaying = false;
+
+// Menus, pause and game over redraw only on input. The music plays on its own
+// thread, so nothing needs a frame meanwhile
+// Where there's no event wait, idle frames still come this often
+#define IDLE_FRAME_MS 100
+static bool isIdle = false;
+static int targetFps = 60;          // --fps, 0 draws as fast as the GPU goes
+static bool resumedFromIdle = false;
+
+// Holding Backspace in game rewinds through the last --rewind seconds, F9
+// dumps the latest tick. Off while an input log records or plays, which
+// can't go back
+#define SNAPSHOT_BUDGET_BYTES (16 << 20)
+#define SNAPSHOT_KEYFRAME_INTERVAL 60
+#define SNAPSHOT_DUMP_PATH "pixel-bloom-snapshot.pbss"
+static float rewindSeconds = 10;
+static SnapshotRing *snapshots = NULL;
 
-    DrawText(buttom_text, buttom.x + 20, buttom.y + buttom.height / 2 - 10, 20, WHITE);
-    return 0;
+ 
+void BuildUI() {
+    musicButton = UiAdd(&ui, UiButton("Music"));
+    pauseButton = UiAdd(&ui, UiButton("Pause"));
+    continueButton = UiAdd(&ui, UiButton("Continue Game"));
+    startButton = UiAdd(&ui, UiButton("Start Game"));
+    restartButton = UiAdd(&ui, UiButton("Restart Game"));
+    exitButton = UiAdd(&ui, UiButton("Exit Game"));
+    deathLabel = UiAdd(&ui, UiLabel("", FONT_SIZE, WHITE));
+    highestScoreLabel = UiAdd(&ui, UiLabel("", FONT_SIZE, WHITE));
+    gardenLabel = UiAdd(&ui, UiLabel("", FONT_SIZE, WHITE));
 }
 
 void PlaceUIButtons(){
     // Add start button
+    Rectangle startMenuRec;
     startMenuRec.x = (game.width / 2) - menu_size_width / 2;
     startMenuRec.y = (game.height / 2) - item_menu_size_height / 1.5f;
     startMenuRec.width = menu_size_width;
     startMenuRec.height = item_menu_size_height;
     // Add restart button
-    restartMenuRec = startMenuRec;
+    const Rectangle restartMenuRec = startMenuRec;
     // Add exit button
+    Rectangle exitMenuRec;
     exitMenuRec.x = (game.width / 2) - menu_size_width / 2;
     exitMenuRec.y = (game.height / 2) + item_menu_size_height / 1.5f;
     exitMenuRec.width = menu_size_width;
     exitMenuRec.height = item_menu_size_height;
-    
+
+    WidgetSetBounds(&ui.widgets[musicButton], (Rectangle){game.width - 210, 10, 100, 40});
+    WidgetSetBounds(&ui.widgets[pauseButton], (Rectangle){game.width - 105, 10, 100, 40});
+    WidgetSetBounds(&ui.widgets[continueButton], (Rectangle){restartMenuRec.x, restartMenuRec.y-restartMenuRec.height-15, restartMenuRec.width, restartMenuRec.height});
+    WidgetSetBounds(&ui.widgets[startButton], startMenuRec);
+    WidgetSetBounds(&ui.widgets[restartButton], restartMenuRec);
+    WidgetSetBounds(&ui.widgets[exitButton], exitMenuRec);
+    WidgetSetBounds(&ui.widgets[deathLabel], (Rectangle){restartMenuRec.x, restartMenuRec.y - 42});
+    WidgetSetBounds(&ui.widgets[highestScoreLabel], (Rectangle){restartMenuRec.x, restartMenuRec.y - 20});
+
     destRec = (Rectangle){ -game.virtualRatio, -game.virtualRatio, game.width + (game.virtualRatio*2), game.height + (game.virtualRatio*2) };
+
+    WidgetSetBounds(&ui.widgets[gardenLabel], (Rectangle){10, 20});
+    if (game.garden.count > 0) {
+        const float gardenWidth = GardenWidth(&game.garden);
+        const float gardenHeight = GardenHeight(&game.garden);
+        gardenCamera.zoom = fminf(game.width / gardenWidth, game.height / gardenHeight);
+        gardenCamera.offset = (Vector2){ (game.width - gardenWidth * gardenCamera.zoom) / 2, (game.height - gardenHeight * gardenCamera.zoom) / 2 };
+    }
+}
+
+void UpdateUIVisibility() {
+    const bool inGame = game.state == StateInGame;
+    const bool gameOver = game.state == StateGameOver;
+    ui.widgets[musicButton].visible = inGame;
+    ui.widgets[pauseButton].visible = inGame;
+    ui.widgets[continueButton].visible = inGame && game.isPaused;
+    ui.widgets[startButton].visible = game.state == StateStartMenu;
+    ui.widgets[restartButton].visible = (inGame && game.isPaused) || gameOver;
+    ui.widgets[exitButton].visible = !inGame || game.isPaused;
+    ui.widgets[deathLabel].visible = gameOver;
+    ui.widgets[highestScoreLabel].visible = gameOver;
+    ui.widgets[gardenLabel].visible = inGame && game.garden.count > 0;
+}
+void UpdateGardenLabel() {
+    const int score = (int)(game.score + 0.5f);
+    if (score == shownGardenScore && game.garden.aliveCount == shownAliveCount) return;
+    shownGardenScore = score;
+    shownAliveCount = game.garden.aliveCount;
+    WidgetSetText(&ui.widgets[gardenLabel], TextFormat("$: %03d   %i of %i flowers", score, game.garden.aliveCount, game.garden.count));
+}
+// The game over texts only change here, not every frame
+void ShowGameOver() {
+    switch (game.gameOverType)
+    {
+        case DehidrationDamage:
+            WidgetSetText(&ui.widgets[deathLabel], "Your flower died by dehidration.");
+            break;
+        case DrawningDamage:
+            WidgetSetText(&ui.widgets[deathLabel], "Your flower died by drawning.");
+            break;
+        case WindDamage:
+            WidgetSetText(&ui.widgets[deathLabel], "Your flower died by too much wind.");
+            break;
+        default:
+            WidgetSetText(&ui.widgets[deathLabel], "");
+            break;
+    }
+    WidgetSetText(&ui.widgets[highestScoreLabel], TextFormat("Highest Score: %03.0f", game.highestScore));
 }
 
 void ResetGame() {
-    game.flower.frameTimer = 0;
-    game.flower.waterLevel = 120;
-    game.flower.currentFrame = 0;
-    game.flower.health = 100;
-    game.flower.isAlive = true;
-    game.cloud.currentFrame = 0;
-    game.sun.currentFrame = 0;
-    game.windArrayAmount = 0;
-    game.waterArrayAmount = 0;
-    game.windParticleCD = WIND_PARTICLES_CD;
-    game.waterParticleCD = WATER_PARTICLES_CD;
-    game.isSunUp = true;
-    game.isShielding = false;
-    game.score = 0;
-    game.gameOverType = NoneDamage;
-    game.skipInput = false;
-    game.isPaused = false;
-    
-    healthRec = (Rectangle){NATIVE_WIDTH-20, NATIVE_HEIGHT-DEFAULT_BAR_HEIGHT, 4, DEFAULT_BAR_HEIGHT};
-    hidrationRec = (Rectangle){NATIVE_WIDTH-10, NATIVE_HEIGHT-DEFAULT_BAR_HEIGHT, 4, DEFAULT_BAR_HEIGHT};
+    SimReset(&game);
 }
-void LoadTextures() {
-    game.flower.texture = LoadTexture("resources/flower.png");
-    game.sun.texture = LoadTexture("resources/sun.png");
-    game.cloud.texture = LoadTexture("resources/cloud.png");
-    game.waterTexture = LoadTexture("resources/water.png");
-    game.healthTexture = LoadTexture("resources/health.png");
+void SaveRecording() {
+    if (!isRecording) return;
+    isRecording = false;
+    if (InputLogSave(&inputLog, &game, recordPath)) {
+        TraceLog(LOG_INFO, "REPLAY: %i ticks recorded to %s", inputLog.tickCount, recordPath);
+    } else {
+        TraceLog(LOG_WARNING, "REPLAY: Could not write %s", recordPath);
+    }
 }
-void UnloadTextures() {
-    if(target.id != 0) {
-        UnloadRenderTexture(target);
+void StartSession() {
+    // A restart ends the session being recorded, the file keeps the latest one
+    SaveRecording();
+    ResetGame();
+    game.state = StateInGame;
+    accumulator = 0;
+    pendingInput = (Input){0};
+    if (isReplaying) {
+        InputLogStart(&inputLog, &game);
+    } else if (recordPath != NULL) {
+        InputLogBegin(&inputLog, &game);
+        isRecording = true;
     }
-    if(game.flower.texture.id != 0) {
-        UnloadTexture(game.flower.texture);
+    if (snapshots != NULL) {
+        SnapshotRingReset(snapshots);
+        SnapshotRingRecord(snapshots, &game);
     }
-    if(game.sun.texture.id != 0) {
-        UnloadTexture(game.sun.texture);
+}
+// Steps back as many ticks as the frame took and forgets the ones after, so
+// letting go of the key plays on from there
+void Rewind(float frameTime) {
+    accumulator += frameTime;
+    int ticks = 0;
+    while (accumulator >= tickDelta) {
+        accumulator -= tickDelta;
+        ticks++;
+    }
+    const long long oldest = SnapshotRingOldest(snapshots);
+    long long tick = SnapshotRingNewest(snapshots) - ticks;
+    if (tick < oldest) tick = oldest;
+    if (ticks == 0 || tick < 0) return;
+    if (SnapshotRingRestore(snapshots, tick, &game)) {
+        SnapshotRingTruncate(snapshots, tick);
     }
-    if(game.cloud.texture.id != 0) {
-        UnloadTexture(game.cloud.texture);
+    // Whatever was held before the rewind isn't held now
+    pendingInput = (Input){0};
+}
+void DumpSnapshot() {
+    const long long tick = SnapshotRingNewest(snapshots);
+    if (tick >= 0 && SnapshotRingDump(snapshots, tick, SNAPSHOT_DUMP_PATH)) {
+        TraceLog(LOG_INFO, "SNAPSHOT: Tick %lld written to %s", tick, SNAPSHOT_DUMP_PATH);
+    } else {
+        TraceLog(LOG_WARNING, "SNAPSHOT: Could not write %s", SNAPSHOT_DUMP_PATH);
     }
-    if(game.healthTexture.id != 0) {
-        UnloadTexture(game.healthTexture);
+}
+void UnloadTextures() {
+    if(target.id != 0) {
+        UnloadRenderTexture(target);
     }
-    if(game.waterTexture.id != 0) {
-        UnloadTexture(game.waterTexture);
+    if (softTexture.id != 0) {
+        UnloadTexture(softTexture);
     }
+    UnloadGameTextures(&textures);
+    UiUnload(&ui);
+    ParticleRendererFree(&particleRenderer);
 }
 void UpdateScreenValues() {
     if(IsWindowFullscreen()) {
@@ -222,363 +296,567 @@ void UpdateScreenValues() {
     }
     game.virtualRatio = game.height/NATIVE_HEIGHT;
 }
-void TakeDamage(float damage, DamageType damageType) {
-    if (!game.flower.isAlive) return;
-    game.flower.health =  game.flower.health - damage;
-    if (game.flower.health <= 0) {
-        game.flower.isAlive = false;
-        game.flower.health = 0;
-        if(game.score > game.highestScore) {
-            game.highestScore = game.score;
-        }
-        game.state = StateGameOver;
-        game.gameOverType = damageType;
-    }
-    const float healthHeight = DEFAULT_BAR_HEIGHT*game.flower.health/100;
-    healthRec.y = NATIVE_HEIGHT-healthHeight;
-    healthRec.height = healthHeight;
-}
-void TakeWater(float water) {
-    if (!game.flower.isAlive) return;
-    game.flower.waterLevel += water;
-    const float hidrationHeight = DEFAULT_BAR_HEIGHT*game.flower.waterLevel/FLOWER_MAX_WATER_LEVEL;
-    hidrationRec.y = NATIVE_HEIGHT-hidrationHeight;
-    hidrationRec.height = hidrationHeight;
-    if (game.flower.waterLevel > FLOWER_MAX_WATER_LEVEL) {
-        TakeDamage(TOO_MUCH_WATER_DAMAGE, DrawningDamage);
-        game.flower.waterLevel = FLOWER_MAX_WATER_LEVEL;
+// Garden mode reads the pointers in garden coordinates, and a click on any
+// flower changes the weather
+Input ReadGardenInput() {
+    Input input = {0};
+    input.shieldPosition = GetScreenToWorld2D(GetMousePosition(), gardenCamera);
+    const int flower = GardenFlowerAt(&game.garden, input.shieldPosition.x, input.shieldPosition.y);
+    const float plotX = input.shieldPosition.x - (flower % game.garden.columns) * GARDEN_PLOT_WIDTH;
+    const float plotY = input.shieldPosition.y - (flower / game.garden.columns) * GARDEN_PLOT_HEIGHT;
+    const bool onFlower = flower >= 0 && plotX >= GARDEN_FLOWER_X && plotY >= GARDEN_PLOT_HEIGHT - 50;
+    input.toggleWeather = IsKeyPressed(KEY_SPACE) || (IsMouseButtonReleased(MOUSE_LEFT_BUTTON) && onFlower);
+    input.shieldPressed = IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
+    input.shieldReleased = IsMouseButtonReleased(MOUSE_LEFT_BUTTON);
+    for (int i = 1; i < GetTouchPointCount() && input.extraShieldCount < MAX_SHIELDS - 1; i++) {
+        input.extraShields[input.extraShieldCount++] = GetScreenToWorld2D(GetTouchPosition(i), gardenCamera);
+    }
+    return input;
+}
+Input ReadInput() {
+    if (game.garden.count > 0) return ReadGardenInput();
+    Input input = {0};
+    SetMouseScale(1 / game.virtualRatio, 1 / game.virtualRatio);
+    const Rectangle flowerButtom = (Rectangle){60, NATIVE_HEIGHT - 50, AtlasFrame(SpriteFlower, 0).width, 50};
+    input.shieldPosition = GetMousePosition();
+    input.toggleWeather = IsKeyPressed(KEY_SPACE) ||
+        (IsMouseButtonReleased(MOUSE_LEFT_BUTTON) &&
+        CheckCollisionPointRec(input.shieldPosition, flowerButtom));
+    input.shieldPressed = IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
+    input.shieldReleased = IsMouseButtonReleased(MOUSE_LEFT_BUTTON);
+    SetMouseScale(1, 1);
+    // Touch 0 already drives the mouse, every other finger holds its own shield
+    for (int i = 1; i < GetTouchPointCount() && input.extraShieldCount < MAX_SHIELDS - 1; i++) {
+        const Vector2 touch = GetTouchPosition(i);
+        input.extraShields[input.extraShieldCount++] = (Vector2){ touch.x / game.virtualRatio, touch.y / game.virtualRatio };
+    }
+    return input;
+}
+void SetIdle(bool idle) {
+    if (idle == isIdle) return;
+    isIdle = idle;
+    resumedFromIdle = !idle;
+#if defined(IDLE_EVENT_WAITING)
+    if (idle) {
+        EnableEventWaiting();
+    } else {
+        DisableEventWaiting();
+    }
+#elif defined(PLATFORM_WEB)
+    // Browsers have no event wait, drop from requestAnimationFrame to a timer
+    if (idle) {
+        emscripten_set_main_loop_timing(EM_TIMING_SETTIMEOUT, IDLE_FRAME_MS);
     } else {
-        game.flower.health += 1;
-        if(game.flower.health > 100) {
-            game.flower.health = 100;
+        emscripten_set_main_loop_timing(EM_TIMING_RAF, 1);
+    }
+#else
+    SetTargetFPS(idle ? 1000 / IDLE_FRAME_MS : targetFps);
+#endif
+}
+// A pointer that moved since the last sample, or a press, is an input the
+// latency meter follows to the swap
+void NoteInput(Vector2 pointer, bool edge) {
+    if (edge || pointer.x != lastPointer.x || pointer.y != lastPointer.y) {
+        LatencyInputSampled(&latency, ProfilerNow());
+    }
+    lastPointer = pointer;
+}
+// Low-latency mode: the shields at screen resolution, the mouse one at the
+// last polled pointer rather than where the last tick left it
+void DrawShieldOverlay() {
+    const Vector2 pointer = GetMousePosition();
+    NoteInput(pointer, false);
+    for (int i = 0; i < game.shieldCount; i++) {
+        Vector2 center = { game.shields[i].x * game.virtualRatio, game.shields[i].y * game.virtualRatio };
+        if (i == 0 && game.isShielding && !isReplaying) {
+            center = pointer;
         }
-        const float healthHeight = DEFAULT_BAR_HEIGHT*game.flower.health/100;
-        healthRec.y = NATIVE_HEIGHT-healthHeight;
-        healthRec.height = healthHeight;
+        DrawCircleV(center, SHIELD_RADIUS * game.virtualRatio, LIGHTGRAY);
+    }
+}
+// Folds a frame's input into the next tick's, so edges between ticks aren't lost
+void MergeInput(Input *pending, Input frame) {
+    // A press after a release leaves the shield held
+    if (frame.shieldPressed) pending->shieldReleased = false;
+    frame.toggleWeather = frame.toggleWeather != pending->toggleWeather;
+    frame.shieldPressed |= pending->shieldPressed;
+    frame.shieldReleased |= pending->shieldReleased;
+    *pending = frame;
+}
+// Plays the music out of resources.pak, once the audio device is up
+bool StartMusic() {
+    if (!AssetPackOpen(&assets, "resources.pak")) {
+        TraceLog(LOG_WARNING, "ASSETS: Could not open resources.pak");
+        return false;
+    }
+    if (!AssetPackLoad(&assets, "musics/ambient.mp3", &musicBlob)) {
+        TraceLog(LOG_WARNING, "ASSETS: musics/ambient.mp3 is not in resources.pak, playing without music");
+        return false;
+    }
+    if (!BackgroundMusicPlay(musicBlob.data, musicBlob.size)) {
+        TraceLog(LOG_WARNING, "AUDIO: Could not play musics/ambient.mp3");
+        return false;
+    }
+    return true;
+}
+#if defined(PLATFORM_WEB)
+// The page doesn't preload resources.pak, so the first frame only waits on
+// the module. It's fetched once that frame is out, and the music starts when
+// it lands, or when the loader is done if that's later
+static bool packFetched = false;
+void StartFetchedMusic() {
+    if (StartMusic()) {
+        TraceLog(LOG_INFO, "STARTUP: Music streamed in %.1f ms after launch", (ProfilerNow() - launchTime) / 1e6);
+    }
+}
+void OnPackFetched(const char *file) {
+    (void)file;
+    packFetched = true;
+    if (loader == NULL && IsAudioDeviceReady()) StartFetchedMusic();
+}
+void OnPackFetchFailed(const char *file) {
+    TraceLog(LOG_WARNING, "ASSETS: Could not fetch %s, playing without music", file);
+}
+#endif
+bool LoadAudio(void *data) {
+    (void)data;
+    InitAudioDevice();
+    if (!IsAudioDeviceReady()) return false;
+#if defined(PLATFORM_WEB)
+    return true;
+#else
+    return StartMusic();
+#endif
+}
+bool LoadSim(void *data) {
+    (void)data;
+    if (gardenFlowers > 0) {
+        if (!SimInitGarden(&game, gardenFlowers)) return false;
+    } else if (weatherField) {
+        if (!SimInitWeatherField(&game)) return false;
+    } else if (!SimInit(&game, DEFAULT_WIND_CAPACITY, DEFAULT_WATER_CAPACITY)) {
+        return false;
     }
+    SimSeed(&game, (uint64_t)time(NULL));
+    game.jobs = JobSystemCreate(0);
+    return true;
 }
+bool LoadTargets(void *data) {
+    (void)data;
+    target = LoadRenderTexture(NATIVE_WIDTH, NATIVE_HEIGHT);
+    if (softRender) {
+        const Image frame = {
+            .data = softFrame.pixels,
+            .width = NATIVE_WIDTH,
+            .height = NATIVE_HEIGHT,
+            .mipmaps = 1,
+            .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+        };
+        softTexture = LoadTextureFromImage(frame);
+    }
+    LatencyInit(&latency, frameQueue);
+    if (capturePath != NULL) {
+        if (gardenFlowers > 0) {
+            TraceLog(LOG_WARNING, "CAPTURE: Garden mode has no native frame to record");
+        } else if (!FrameCaptureStart(&capture, capturePath, NATIVE_WIDTH, NATIVE_HEIGHT, targetFps > 0 ? targetFps : 60)) {
+            TraceLog(LOG_WARNING, "CAPTURE: Could not create %s", capturePath);
+        }
+    }
+    return target.id != 0;
+}
+bool LoadSprites(void *data) {
+    (void)data;
+    LoadGameTextures(&textures);
+    return textures.atlas.id != 0;
+}
+bool LoadParticleRenderer(void *data) {
+    (void)data;
+    ParticleRendererInit(&particleRenderer, ParticleRenderAuto);
+    return true;
+}
+// Everything after the loader, which only takes the main thread a moment
+void FinishLoading() {
+    bool simLoaded = false;
+    for (int i = 0; i < LoaderStepCount(loader); i++) {
+        LoadStepInfo step;
+        LoaderStepInfo(loader, i, &step);
+        TraceLog(LOG_INFO, "STARTUP: %-16s %-6s at %7.2f ms, took %7.2f ms%s", step.name, step.onMain ? "main" : "worker",
+            step.startedAt, step.milliseconds, step.ok ? "" : " (failed)");
+        if (strcmp(step.name, "sim") == 0) simLoaded = step.ok;
+    }
+    LoaderDestroy(loader);
+    loader = NULL;
+    if (!simLoaded) {
+        if (gardenFlowers > 0) {
+            TraceLog(LOG_FATAL, "Could not allocate a garden of %i flowers", gardenFlowers);
+        }
+        TraceLog(LOG_FATAL, "Could not allocate the particle stores");
+    }
+    if (gardenFlowers > 0 && weatherField) {
+        TraceLog(LOG_WARNING, "WEATHER: Garden mode has no field weather, playing with particles");
+    }
+    if (gardenFlowers > 0) {
+        TraceLog(LOG_INFO, "GARDEN: %i flowers in %ix%i plots", game.garden.count, game.garden.columns, game.garden.rows);
+    }
+    TraceLog(LOG_INFO, "JOBS: Particle passes run on %i threads", JobsThreadCount(game.jobs));
+#if defined(PLATFORM_WEB)
+    if (packFetched && IsAudioDeviceReady()) StartFetchedMusic();
+#endif
+    if (rewindSeconds > 0) {
+        snapshots = SnapshotRingCreate((int)(rewindSeconds / tickDelta) + 1, SNAPSHOT_BUDGET_BYTES, SNAPSHOT_KEYFRAME_INTERVAL);
+        if (snapshots == NULL) {
+            TraceLog(LOG_WARNING, "SNAPSHOT: Could not allocate the rewind history, playing without rewind");
+        }
+    }
 
+    UpdateScreenValues();
+    BuildUI();
+    PlaceUIButtons();
+    ResetGame();
+    sourceRec = (Rectangle){ 0.0f, 0.0f, target.texture.width, - target.texture.height };
+    destRec = (Rectangle){ -game.virtualRatio, -game.virtualRatio, game.width + (game.virtualRatio*2), game.height + (game.virtualRatio*2) };
+
+    game.state = StateStartMenu;
+    game.highestScore = 0;
+    if (replayPath != NULL) {
+        if (!InputLogLoad(&inputLog, replayPath)) {
+            TraceLog(LOG_WARNING, "REPLAY: Could not load %s", replayPath);
+        } else if (inputLog.windCapacity != game.wind.capacity || inputLog.waterCapacity != game.water.capacity ||
+            inputLog.weatherField != (game.weather.wind != NULL)) {
+            TraceLog(LOG_WARNING, "REPLAY: %s was recorded with other particle capacities or weather, play it with pixel-bloom-headless", replayPath);
+        } else {
+            // Replays skip the start menu and never overwrite a recording
+            recordPath = NULL;
+            isReplaying = true;
+            StartSession();
+        }
+    }
+#if !defined(PLATFORM_WEB)
+    ToggleFullscreen();
+    game.width = GetMonitorWidth(GetCurrentMonitor());
+    game.height = GetMonitorHeight(GetCurrentMonitor());
+    UpdateScreenValues();
+#endif
+    TraceLog(LOG_INFO, "STARTUP: Ready %.1f ms after launch", (ProfilerNow() - launchTime) / 1e6);
+}
+// Progress screen while the loader runs. The frame goes out first, so the
+// window shows something before any step blocks the main thread
+void UpdateLoading() {
+    const float progress = LoaderProgress(loader);
+    const int barWidth = GetScreenWidth() / 2;
+    const int barX = (GetScreenWidth() - barWidth) / 2;
+    const int barY = GetScreenHeight() / 2;
+    BeginDrawing();
+        ClearBackground(DARKGRAY);
+        DrawText("Loading", barX, barY - 30, FONT_SIZE, RAYWHITE);
+        DrawRectangle(barX, barY, barWidth, 8, GRAY);
+        DrawRectangle(barX, barY, (int)(barWidth * progress), 8, RAYWHITE);
+    EndDrawing();
+    if (!firstFrameShown) {
+        firstFrameShown = true;
+        TraceLog(LOG_INFO, "STARTUP: First frame %.1f ms after launch", (ProfilerNow() - launchTime) / 1e6);
+#if defined(PLATFORM_WEB)
+        emscripten_async_wget("resources.pak", "resources.pak", OnPackFetched, OnPackFetchFailed);
+#endif
+    }
+    if (LoaderUpdate(loader, LOADING_BUDGET_MS)) {
+        FinishLoading();
+    }
+}
 void UpdateFrame() {
+    if (loader != NULL) {
+        UpdateLoading();
+        return;
+    }
     if(!isPlaying) {
+        SetIdle(true);
         BeginDrawing();
             ClearBackground(BLACK);
             DrawText("The game is Closed", game.width/2-20, game.height/2-10, 20, WHITE);
         EndDrawing();
         return;
     }
+    // Before any input is read, so it's read as close to the swap as the queue allows
+    LatencyWaitForQueue(&latency);
     if(IsWindowResized()){
+        UpdateScreenValues();
         PlaceUIButtons();
     }
+    if (IsKeyPressed(KEY_F3)) {
+        showProfiler = !showProfiler;
+        ProfilerSetEnabled(showProfiler);
+    }
+    if (IsKeyPressed(KEY_F4)) {
+        // Perfetto or chrome://tracing open it
+        const char *tracePath = "pixel-bloom-trace.json";
+        if (ProfilerWriteChromeTrace(tracePath)) {
+            TraceLog(LOG_INFO, "PROFILER: Trace written to %s", tracePath);
+        } else {
+            TraceLog(LOG_WARNING, "PROFILER: Could not write %s", tracePath);
+        }
+    }
+    const bool canRewind = snapshots != NULL && !isRecording && !isReplaying;
+    if (canRewind && game.state == StateInGame && IsKeyPressed(KEY_F9)) {
+        DumpSnapshot();
+    }
     // Tick
-    UpdateMusicStream(music);   // Update music buffer with new stream data
     if(game.state == StateInGame){
-        const float delta = GetFrameTime();
-        if(!game.isPaused) {
-            if (IsWindowResized()) {
-                if(IsWindowFullscreen()) {
-                    game.width = GetMonitorWidth(GetCurrentMonitor());
-                    game.height = GetMonitorHeight(GetCurrentMonitor());
-                }else{
-                    game.width = GetScreenWidth();
-                    game.height = GetScreenHeight();
-                }
-                UpdateScreenValues();
+        if (!game.isPaused && canRewind && IsKeyDown(KEY_BACKSPACE)) {
+            Rewind(GetFrameTime());
+        } else if(!game.isPaused) {
+            PROFILE_BEGIN(inputZone, "input");
+            const Input frameInput = ReadInput();
+            MergeInput(&pendingInput, frameInput);
+            if (!lowLatency) {
+                NoteInput(GetMousePosition(), frameInput.shieldPressed || frameInput.shieldReleased || frameInput.toggleWeather);
+            } else if (frameInput.shieldPressed || frameInput.shieldReleased || frameInput.toggleWeather) {
+                LatencyInputSampled(&latency, ProfilerNow());
             }
-            SetMouseScale(1 / game.virtualRatio, 1 / game.virtualRatio);
-            const Rectangle flowerButtom = (Rectangle){60, NATIVE_HEIGHT - 50, game.flower.texture.width / FLOWER_FRAMES, 50};
-            const Vector2 mousePosition = GetMousePosition();
-            if (IsKeyPressed(KEY_SPACE) ||
-                (IsMouseButtonReleased(MOUSE_LEFT_BUTTON) && 
-                CheckCollisionPointRec(mousePosition, flowerButtom))) {
-                game.isSunUp = !game.isSunUp;
-                game.cloud.currentFrame = 0;
-                game.sun.currentFrame = 0;
-                game.windArrayAmount = 0;
-                game.waterArrayAmount = 0;
-                game.windParticleCD = WIND_PARTICLES_CD;
-                game.waterParticleCD = WATER_PARTICLES_CD;
-                game.skipInput = true;
+            PROFILE_END(inputZone);
+            float frameTime = GetFrameTime();
+            if (resumedFromIdle) {
+                // The last frame time still holds the wait for the input that woke us
+                frameTime = tickDelta;
+                resumedFromIdle = false;
             }
-            if(game.skipInput){
-                game.shieldPosition = (Vector2){0};
-                game.isShielding = false;
-            }else{
-                if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                    game.isShielding = true;
+            accumulator += frameTime;
+            PROFILE_BEGIN(simZone, "sim");
+            int ticks = 0;
+            while (accumulator >= tickDelta && ticks < MAX_CATCH_UP_TICKS && game.state == StateInGame) {
+                Input input = pendingInput;
+                float delta = tickDelta;
+                if (isReplaying && !InputLogPlay(&inputLog, &game, &input, &delta)) {
+                    TraceLog(LOG_INFO, "REPLAY: Finished after %i ticks, the mouse has the shield back", inputLog.tickCount);
+                    isReplaying = false;
                 }
-                if (IsMouseButtonReleased(MOUSE_LEFT_BUTTON)) {
-                    game.shieldPosition = (Vector2){0};
-                    game.isShielding = false;
+                if (isRecording && !InputLogRecord(&inputLog, &game, input, delta)) {
+                    TraceLog(LOG_WARNING, "REPLAY: Out of memory, recording stopped");
+                    isRecording = false;
                 }
-            }
-            if(game.isShielding) {
-                game.shieldPosition = mousePosition;
-            }
-            game.skipInput = false;
-
-            // Calc Score
-            if(game.flower.isAlive && game.isSunUp) {
-                game.score += game.flower.health/100 * delta;
-            }
-            SetMouseScale(1, 1);
-            if (game.isSunUp) {
-                game.sun.frameTimer += delta;
-                if (game.sun.frameTimer >= SUN_FRAME_SPEED) {
-                    game.sun.frameTimer = 0;
-                    game.sun.currentFrame = GetRandomValue(0, SUN_FRAMES - 1);
-                    if (game.sun.currentFrame >= SUN_FRAMES) game.sun.currentFrame = 0;
-                }
-            } else {
-                game.cloud.frameTimer += delta;
-                if (game.cloud.frameTimer >= CLOUD_FRAME_SPEED) {
-                    game.cloud.frameTimer = 0;
-                    game.cloud.currentFrame += 1;
-                    if (game.cloud.currentFrame >= CLOUD_FRAMES) game.cloud.currentFrame = 0;
+                SimStep(&game, input, delta);
+                if (snapshots != NULL && !SnapshotRingRecord(snapshots, &game)) {
+                    TraceLog(LOG_WARNING, "SNAPSHOT: A tick doesn't fit the rewind budget, rewind stopped");
+                    SnapshotRingDestroy(snapshots);
+                    snapshots = NULL;
                 }
+                // Presses and toggles happen once, where the shields are holds
+                pendingInput.toggleWeather = false;
+                pendingInput.shieldPressed = false;
+                pendingInput.shieldReleased = false;
+                accumulator -= tickDelta;
+                ticks++;
             }
-            if(game.flower.isAlive) {
-                game.flower.frameTimer += delta;
-                if (game.flower.frameTimer >= FLOWER_FRAME_SPEED) {
-                    game.flower.frameTimer = 0;
-                    game.flower.currentFrame += 1;
-                    if (game.flower.currentFrame >= FLOWER_FRAMES) game.flower.currentFrame = 0;
-                }
-                if (game.flower.waterLevel != 0.0) {
-                    if(game.isSunUp){
-                        game.flower.waterLevel = game.flower.waterLevel - (FLOWER_WATER_DRAIN_SPEED * delta);
-                        const float hidrationHeight = DEFAULT_BAR_HEIGHT*game.flower.waterLevel/FLOWER_MAX_WATER_LEVEL;
-                        hidrationRec.y = NATIVE_HEIGHT-hidrationHeight;
-                        hidrationRec.height = hidrationHeight;
-                    }
-                }else{
-                    TakeDamage(DEHIDRATION_DAMAGE * delta, DehidrationDamage);
-                }
-                if (game.flower.waterLevel < 0.0) {
-                    game.flower.waterLevel = 0.0;
-                    TakeDamage(DEHIDRATION_DAMAGE * delta, DehidrationDamage);
-                }
+            // A hitch drops what it can't catch up on instead of spiraling
+            if (accumulator >= tickDelta) {
+                accumulator = fmodf(accumulator, tickDelta);
             }
-            
-            if (game.isSunUp) {
-                game.windParticleCD -= delta;
-                for (int i = 0; i < game.windArrayAmount; i++) {
-                    game.windArray[i].position.x += game.windArray[i].power * delta;
-                    if (game.windArray[i].position.x > NATIVE_WIDTH - 85) {
-                        TakeDamage(game.windArray[i].power, WindDamage);
-                        game.windArray[i] = game.windArray[game.windArrayAmount - 1];
-                        game.windArrayAmount -= 1;
-                    } else if (game.isShielding && CheckCollisionPointCircle(game.windArray[i].position, game.shieldPosition, SHIELD_RADIUS)) {
-                        game.windArray[i] = game.windArray[game.windArrayAmount - 1];
-                        game.windArrayAmount -= 1;
-                    }
-                }
-                if (game.windParticleCD < 0) {
-                    game.windParticleCD = WIND_PARTICLES_CD;
-                    if (game.windArrayAmount < MAX_WIND_PARTICLES) {
-                        game.windArray[game.windArrayAmount].power = 10 + GetRandomValue(1,10);
-                        game.windArray[game.windArrayAmount].position.y = NATIVE_HEIGHT - 30 + GetRandomValue(1,20);
-                        game.windArray[game.windArrayAmount].position.x = 1;
-                        game.windArrayAmount += 1;
-                    }
-                }
-            } else {
-                for (int i = 0; i < game.waterArrayAmount; i++) {
-                    game.waterArray[i].position.y += game.waterArray[i].amount * 10 * delta;
-                    if (game.waterArray[i].position.y > NATIVE_WIDTH - 85) {
-                        TakeWater(game.waterArray[i].amount);
-                        game.waterArray[i] = game.waterArray[game.waterArrayAmount - 1];
-                        game.waterArrayAmount -= 1;
-                    } else if (game.isShielding && CheckCollisionPointCircle(game.waterArray[i].position, game.shieldPosition, SHIELD_RADIUS)) {
-                        game.waterArray[i] = game.waterArray[game.waterArrayAmount - 1];
-                        game.waterArrayAmount -= 1;
-                    }
-                }
-                game.waterParticleCD -= delta;
-                if (game.waterParticleCD < 0) {
-                    game.waterParticleCD = WATER_PARTICLES_CD;
-                    if (game.waterArrayAmount < MAX_WATER_PARTICLES) {
-                        game.waterArrayAmount += 1;
-                    }
-                    game.waterArray[game.waterArrayAmount - 1].amount = GetRandomValue(1, 10);
-                    game.waterArray[game.waterArrayAmount - 1].position.y = 0;
-                    game.waterArray[game.waterArrayAmount - 1].position.x = 60 + GetRandomValue(1, 20);
-                }
+            PROFILE_END(simZone);
+            if (game.state == StateGameOver) {
+                SaveRecording();
+                ShowGameOver();
             }
         }
-        BeginTextureMode(target);
-            ClearBackground(DARKGRAY);
-            if (game.isSunUp) {
-                game.windParticleCD -= delta;
-                for (int i = 0; i < game.windArrayAmount; i++) {
-                    DrawPixelV(game.windArray[i].position, RAYWHITE);
-                }
-                const int sunDiv = game.sun.texture.width/SUN_FRAMES;
-                DrawTextureRec(game.sun.texture, (Rectangle){ game.sun.currentFrame * sunDiv, 0, sunDiv, game.sun.texture.height}, (Vector2){0, 0}, WHITE);
+        if (game.garden.count == 0) {
+            PROFILE_BEGIN(targetZone, "target render");
+            if (softRender) {
+                SoftRenderFrame(&softFrame, &game, tickDelta - accumulator, !lowLatency);
+                UpdateTexture(softTexture, softFrame.pixels);
+                FrameCapturePixels(&capture, softFrame.pixels);
             } else {
-                for (int i = 0; i < game.waterArrayAmount; i++) {
-                    DrawPixelV(game.waterArray[i].position, RAYWHITE);
-                    i += 1;
-                }
-                game.waterParticleCD -= delta;
-                if (game.waterParticleCD < 0) {
-                    game.waterParticleCD = WATER_PARTICLES_CD;
-                    if (game.waterArrayAmount < MAX_WATER_PARTICLES) {
-                        game.waterArrayAmount += 1;
-                    }
-                    game.waterArray[game.waterArrayAmount - 1].amount = GetRandomValue(1, 10);
-                    game.waterArray[game.waterArrayAmount - 1].position.y = 0;
-                    game.waterArray[game.waterArrayAmount - 1].position.x = 60 + GetRandomValue(1, 20);
-                }
-                const int cloudDiv = game.cloud.texture.width/CLOUD_FRAMES;
-                DrawTextureRec(game.cloud.texture, (Rectangle){game.cloud.currentFrame * cloudDiv, 0, cloudDiv, game.cloud.texture.height}, (Vector2){40, 0}, WHITE);
-            }
-            const int flowerDiv = game.flower.texture.width/FLOWER_FRAMES;
-            DrawTextureRec(game.flower.texture, (Rectangle){game.flower.currentFrame * flowerDiv, 0, flowerDiv, game.flower.texture.height}, (Vector2){60, NATIVE_HEIGHT - game.flower.texture.height}, WHITE);
-            DrawRectangleRec(healthRec, WHITE);
-            DrawRectangleRec(hidrationRec, WHITE);
-            DrawTextureV(game.healthTexture,(Vector2){healthRec.x-2, NATIVE_HEIGHT - DEFAULT_BAR_HEIGHT - 10},WHITE);
-            DrawTextureV(game.waterTexture,(Vector2){hidrationRec.x-2, NATIVE_HEIGHT - DEFAULT_BAR_HEIGHT - 10},WHITE);
-            DrawText(TextFormat("$: %03.0f", game.score), NATIVE_WIDTH - 30, DEFAULT_BAR_HEIGHT-30, 1, WHITE);
-
-            if (game.isShielding) {
-                DrawCircleV(game.shieldPosition, SHIELD_RADIUS, LIGHTGRAY);
+                DrawNativeFrame(target, &game, &textures, &particleRenderer, tickDelta - accumulator, !lowLatency);
+                FrameCaptureTexture(&capture, target);
             }
-        EndTextureMode();
+            PROFILE_END(targetZone);
+        } else {
+            UpdateGardenLabel();
+        }
     }
 
+    PROFILE_BEGIN(uiZone, "ui");
+    // One hit test a frame against the bounds laid out on resize
+    const int clicked = IsMouseButtonReleased(MOUSE_LEFT_BUTTON) ? UiHitTest(&ui, GetMousePosition()) : -1;
+    if (clicked == musicButton) {
+        game.isMusicPaused = !game.isMusicPaused;
+        BackgroundMusicSetPaused(game.isMusicPaused);
+    } else if (clicked == pauseButton) {
+        game.isPaused = !game.isPaused;
+    } else if (clicked == continueButton) {
+        game.isPaused = false;
+    } else if (clicked == startButton || clicked == restartButton) {
+        // Initialize game
+        StartSession();
+    } else if (clicked == exitButton) {
+        // Exit game
+        isPlaying = false;
+        PROFILE_END(uiZone);
+        return;
+    }
+    // After StartSession's reset, so the click doesn't also raise the shield
+    if (clicked >= 0) {
+        game.skipInput = true;
+    }
+    UpdateUIVisibility();
+    UiRefresh(&ui);
+
     BeginDrawing();
         ClearBackground(DARKGRAY);
-        switch (game.state)
-        {
-            case StateInGame:
+        if (game.state == StateInGame && game.garden.count > 0) {
+            PROFILE_BEGIN(gardenZone, "garden render");
+            BeginMode2D(gardenCamera);
+                DrawGardenFrame(&game, &textures, &particleRenderer, tickDelta - accumulator);
+            EndMode2D();
+            PROFILE_END(gardenZone);
+        } else if (game.state == StateInGame) {
+            PROFILE_BEGIN(upscaleZone, "upscale");
+            if (softRender) {
+                DrawTexturePro(softTexture, (Rectangle){ 0, 0, NATIVE_WIDTH, NATIVE_HEIGHT }, destRec, (Vector2){0}, 0.0f, WHITE);
+            } else {
                 DrawTexturePro(target.texture, sourceRec, destRec, (Vector2){0}, 0.0f, WHITE);
-                
-                if (MenuButtom((Rectangle){game.width - 210, 10, 100, 40}, "Music"))
-                {
-                    if(game.isMusicPaused){
-                        ResumeMusicStream(music);
-                        game.isMusicPaused = false;
-                    }else{
-                        PauseMusicStream(music);
-                        game.isMusicPaused = true;
-                    }
-                }
-                if (MenuButtom((Rectangle){game.width - 105, 10, 100, 40}, "Pause"))
-                {
-                    game.isPaused = !game.isPaused;
-                }
-                if(game.isPaused) {
-                    const Rectangle tempPauseRec = (Rectangle){restartMenuRec.x, restartMenuRec.y-restartMenuRec.height-15, restartMenuRec.width, restartMenuRec.height};
-                    if (MenuButtom(tempPauseRec, "Continue Game"))
-                    {
-                        // Initialize game
-                        game.isPaused = false;
-                    }
-                    if (MenuButtom(restartMenuRec, "Restart Game"))
-                    {
-                        // Initialize game
-                        ResetGame();
-                        game.state = StateInGame;
-                    }
-                    if (MenuButtom(exitMenuRec, "Exit Game"))
-                    {
-                        // Exit game
-                        isPlaying = false;
-                        return;
-                    }
-                }
-
-                break;
-            case StateStartMenu:
-                if (MenuButtom(startMenuRec, "Start Game"))
-                {
-                    // Initialize game
-                    game.state = StateInGame;
-                }
-                if (MenuButtom(exitMenuRec, "Exit Game")){
-                    // Exit game
-                    isPlaying = false;
-                    return;
-                }
-                
-                break;
-            case StateGameOver:
-                switch (game.gameOverType)
-                {
-                    case DehidrationDamage:
-                        DrawText("Your flower died by dehidration.", restartMenuRec.x, restartMenuRec.y - 42, FONT_SIZE, WHITE);
-                        break;
-                    case DrawningDamage:
-                        DrawText("Your flower died by drawning.", restartMenuRec.x, restartMenuRec.y - 42, FONT_SIZE, WHITE);
-                        break;
-                    case WindDamage:
-                        DrawText("Your flower died by too much wind.", restartMenuRec.x, restartMenuRec.y - 42, FONT_SIZE, WHITE);
-                        break;
-                    default:
-                        break;
-                }
-                DrawText(TextFormat("Highest Score: %03.0f", game.highestScore), restartMenuRec.x, restartMenuRec.y - 20, FONT_SIZE, WHITE);
-                if (MenuButtom(restartMenuRec, "Restart Game"))
-                {
-                    // Initialize game
-                    ResetGame();
-                    game.state = StateInGame;
-                }
-                if (MenuButtom(exitMenuRec, "Exit Game"))
-                {
-                    // Exit game
-                    isPlaying = false;
-                    return;
-                }
-                break;
+            }
+            if (lowLatency) {
+                DrawShieldOverlay();
+            }
+            PROFILE_END(upscaleZone);
+        }
+        UiDraw(&ui);
+        PROFILE_END(uiZone);
+        if (showProfiler) {
+            DrawProfilerOverlay(10, 60, 10);
+            const ProfileStats lag = LatencyStats(&latency);
+            DrawText(TextFormat("input to swap ms  p50 %.2f  p95 %.2f  p99 %.2f  max %.2f", lag.p50, lag.p95, lag.p99, lag.max), 10, 46, 10, YELLOW);
+            if (snapshots != NULL && SnapshotRingNewest(snapshots) >= 0) {
+                const long long stored = SnapshotRingNewest(snapshots) - SnapshotRingOldest(snapshots) + 1;
+                DrawText(TextFormat("rewind %.1f s in %.1f KB", stored * tickDelta, SnapshotRingBytes(snapshots) / 1024.0f), 10, 32, 10, YELLOW);
+            }
         }
         // DrawText(TextFormat("FPS: %d", GetFPS()), 10, 12, FONT_SIZE, RED);
+    // Decided before EndDrawing, which is where an idle frame waits for input
+    SetIdle(game.state != StateInGame || game.isPaused);
+    PROFILE_BEGIN(presentZone, "present");
     EndDrawing();
+    LatencyFrameSwapped(&latency);
+    PROFILE_END(presentZone);
+    ProfilerFrameEnd();
+
+}
+
+static void PrintUsage(const char *program) {
+    printf("usage: %s [--record FILE] [--replay FILE] [--tick-rate HZ] [--fps N] [--garden FLOWERS] [--soft-render 0|1] [--capture FILE] [--low-latency 0|1] [--frame-queue N] [--weather particles|field] [--rewind SECONDS]\n", program);
+}
 
+// Every option takes a value, as in the headless runner
+static bool ParseOptions(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--help") == 0) {
+            return false;
+        }
+        if (value == NULL) {
+            fprintf(stderr, "missing value for %s\n", arg);
+            return false;
+        }
+        if (strcmp(arg, "--record") == 0) {
+            recordPath = value;
+        } else if (strcmp(arg, "--replay") == 0) {
+            replayPath = value;
+        } else if (strcmp(arg, "--tick-rate") == 0) {
+            if (atof(value) <= 0) {
+                fprintf(stderr, "bad tick rate %s\n", value);
+                return false;
+            }
+            tickDelta = 1.0f / (float)atof(value);
+        } else if (strcmp(arg, "--fps") == 0) {
+            targetFps = atoi(value);
+        } else if (strcmp(arg, "--garden") == 0) {
+            gardenFlowers = atoi(value);
+        } else if (strcmp(arg, "--soft-render") == 0) {
+            softRender = atoi(value) != 0;
+        } else if (strcmp(arg, "--capture") == 0) {
+            capturePath = value;
+        } else if (strcmp(arg, "--low-latency") == 0) {
+            lowLatency = atoi(value) != 0;
+        } else if (strcmp(arg, "--frame-queue") == 0) {
+            frameQueue = atoi(value);
+        } else if (strcmp(arg, "--weather") == 0) {
+            if (strcmp(value, "field") != 0 && strcmp(value, "particles") != 0) {
+                fprintf(stderr, "unknown weather %s\n", value);
+                return false;
+            }
+            weatherField = strcmp(value, "field") == 0;
+        } else if (strcmp(arg, "--rewind") == 0) {
+            rewindSeconds = (float)atof(value);
+        } else {
+            fprintf(stderr, "unknown option %s\n", arg);
+            return false;
+        }
+        i++;
+    }
+    return true;
 }
 
-int main(void) {
+int main(int argc, char **argv) {
+    launchTime = ProfilerNow();
+#if defined(PLATFORM_WEB)
+    // The download and compile of the module, the page's clock starts with it
+    TraceLog(LOG_INFO, "STARTUP: Module running %.1f ms after the page started loading", emscripten_performance_now());
+#endif
+    if (!ParseOptions(argc, argv)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
     // Start game
     game.width = 800;
     game.height = 450;
     // Start Raylib Window
     InitWindow(game.width, game.height, "Pixel Bloom");
 
-    InitAudioDevice();   
-
-    target = LoadRenderTexture(NATIVE_WIDTH, NATIVE_HEIGHT);
-    LoadTextures();
-    
-    music = LoadMusicStream("resources/musics/ambient.mp3");
-    PlayMusicStream(music);
-
-    UpdateScreenValues();
-    PlaceUIButtons();
-    ResetGame();
-    sourceRec = (Rectangle){ 0.0f, 0.0f, target.texture.width, - target.texture.height };
-    destRec = (Rectangle){ -game.virtualRatio, -game.virtualRatio, game.width + (game.virtualRatio*2), game.height + (game.virtualRatio*2) };
-
-    game.state = StateStartMenu;
-    game.highestScore = 0;
+    loader = LoaderCreate();
+    if (loader == NULL) {
+        TraceLog(LOG_FATAL, "Could not create the loader");
+    }
+#if !defined(PLATFORM_WEB)
+    LoaderAdd(loader, "audio", LoadAudio, NULL, false);
+#endif
+    LoaderAdd(loader, "sim", LoadSim, NULL, false);
+    LoaderAdd(loader, "render targets", LoadTargets, NULL, true);
+    LoaderAdd(loader, "sprites", LoadSprites, NULL, true);
+    LoaderAdd(loader, "particle shaders", LoadParticleRenderer, NULL, true);
+#if defined(PLATFORM_WEB)
+    // Web Audio only exists on the page's thread, where the textures go first
+    LoaderAdd(loader, "audio", LoadAudio, NULL, true);
+#endif
+    LoaderStart(loader);
 
 #if defined(PLATFORM_WEB)
     emscripten_set_main_loop(UpdateFrame, 0, 1);
 #else
-    ToggleFullscreen();
-    
-    game.width = GetMonitorWidth(GetCurrentMonitor());
-    game.height = GetMonitorHeight(GetCurrentMonitor());
-    UpdateScreenValues();
-
-    SetTargetFPS(60);
+    SetTargetFPS(targetFps);
     // Main game loop
     while (!WindowShouldClose() && isPlaying) {
         UpdateFrame();
     }
 #endif
     
+    // Closed while loading, the workers still have to finish
+    LoaderDestroy(loader);
+    SaveRecording();
+    InputLogFree(&inputLog);
+    SnapshotRingDestroy(snapshots);
+    FrameCaptureStop(&capture);
+    const ProfileStats lag = LatencyStats(&latency);
+    TraceLog(LOG_INFO, "LATENCY: Input to swap p50 %.2f p95 %.2f p99 %.2f max %.2f ms over the last %i inputs",
+        lag.p50, lag.p95, lag.p99, lag.max, latency.historyCount);
+    LatencyFree(&latency);
     UnloadTextures();
-    UnloadMusicStream(music);
+    if (BackgroundMusicUnderruns() > 0) {
+        TraceLog(LOG_INFO, "AUDIO: The music ran dry %i times", BackgroundMusicUnderruns());
+    }
+    BackgroundMusicStop();
+    AssetBlobFree(&musicBlob);
+    AssetPackClose(&assets);
+    SimFree(&game);
+    JobSystemDestroy(game.jobs);
     CloseAudioDevice();
     CloseWindow();
 
@@ -0,0 +1,197 @@
+#include "particle_renderer.h"
+
+#include "raymath.h"
+#include "rlgl.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Floats uploaded per particle
+#define INSTANCED_FLOATS 2              // x, y
+#define EXPANDED_FLOATS 12              // two triangles of x, y
+
+static const float unitQuad[12] = {
+    0, 0,  1, 0,  1, 1,
+    0, 0,  1, 1,  0, 1,
+};
+
+static const char *instancedVs =
+    "in vec2 vertexPosition;\n"
+    "in vec2 instanceOffset;\n"
+    "uniform mat4 mvp;\n"
+    "void main() { gl_Position = mvp*vec4(vertexPosition + instanceOffset, 0.0, 1.0); }\n";
+static const char *instancedFs =
+    "uniform vec4 particleColor;\n"
+    "out vec4 finalColor;\n"
+    "void main() { finalColor = particleColor; }\n";
+static const char *expandedVs =
+    "attribute vec2 vertexPosition;\n"
+    "uniform mat4 mvp;\n"
+    "void main() { gl_Position = mvp*vec4(vertexPosition, 0.0, 1.0); }\n";
+static const char *expandedFs =
+    "uniform vec4 particleColor;\n"
+    "void main() { gl_FragColor = particleColor; }\n";
+
+static ParticleRenderMode BestMode(void) {
+    switch (rlGetVersion()) {
+        case RL_OPENGL_33:
+        case RL_OPENGL_43:
+        case RL_OPENGL_ES_30:
+            return ParticleRenderInstanced;
+        case RL_OPENGL_21:
+        case RL_OPENGL_ES_20:
+            return ParticleRenderExpanded;
+        default:
+            return ParticleRenderPixels;
+    }
+}
+
+static const char *ShaderHeader(int version) {
+    switch (version) {
+        case RL_OPENGL_33:
+        case RL_OPENGL_43:
+            return "#version 330\n";
+        case RL_OPENGL_ES_30:
+            return "#version 300 es\nprecision mediump float;\n";
+        case RL_OPENGL_ES_20:
+            return "#version 100\nprecision mediump float;\n";
+        default:
+            return "#version 120\n";
+    }
+}
+
+static bool LoadParticleShader(ParticleRenderer *renderer) {
+    const bool instanced = renderer->mode == ParticleRenderInstanced;
+    const char *header = ShaderHeader(rlGetVersion());
+    char vs[512];
+    char fs[512];
+    snprintf(vs, sizeof(vs), "%s%s", header, instanced ? instancedVs : expandedVs);
+    snprintf(fs, sizeof(fs), "%s%s", header, instanced ? instancedFs : expandedFs);
+    renderer->shader = LoadShaderFromMemory(vs, fs);
+    if (!IsShaderValid(renderer->shader) || renderer->shader.id == rlGetShaderIdDefault()) return false;
+    renderer->mvpLoc = GetShaderLocation(renderer->shader, "mvp");
+    renderer->colorLoc = GetShaderLocation(renderer->shader, "particleColor");
+    renderer->offsetLoc = instanced ? GetShaderLocationAttrib(renderer->shader, "instanceOffset") : -1;
+    return !instanced || renderer->offsetLoc >= 0;
+}
+
+void ParticleRendererInit(ParticleRenderer *renderer, ParticleRenderMode mode) {
+    *renderer = (ParticleRenderer){0};
+    renderer->mode = (mode == ParticleRenderAuto) ? BestMode() : mode;
+    if (renderer->mode == ParticleRenderPixels) return;
+
+    if (!LoadParticleShader(renderer)) {
+        TraceLog(LOG_WARNING, "PARTICLES: Shader failed, drawing particles one pixel at a time");
+        ParticleRendererFree(renderer);
+        renderer->mode = ParticleRenderPixels;
+        return;
+    }
+    renderer->vao = rlLoadVertexArray();
+    if (renderer->mode == ParticleRenderInstanced) {
+        renderer->quadVbo = rlLoadVertexBuffer(unitQuad, sizeof(unitQuad), false);
+    }
+    TraceLog(LOG_INFO, "PARTICLES: Drawing particles %s", renderer->mode == ParticleRenderInstanced ? "instanced" : "as one triangle list");
+}
+
+void ParticleRendererFree(ParticleRenderer *renderer) {
+    if (renderer->shader.id != 0 && renderer->shader.id != rlGetShaderIdDefault()) UnloadShader(renderer->shader);
+    if (renderer->vao != 0) rlUnloadVertexArray(renderer->vao);
+    if (renderer->quadVbo != 0) rlUnloadVertexBuffer(renderer->quadVbo);
+    if (renderer->vertexVbo != 0) rlUnloadVertexBuffer(renderer->vertexVbo);
+    free(renderer->staging);
+    const ParticleRenderMode mode = renderer->mode;
+    *renderer = (ParticleRenderer){0};
+    renderer->mode = mode;
+}
+
+static int FloatsPerParticle(const ParticleRenderer *renderer) {
+    return renderer->mode == ParticleRenderInstanced ? INSTANCED_FLOATS : EXPANDED_FLOATS;
+}
+
+// Grows the staging memory and the GPU buffer together, doubling like a vector.
+// On failure the capacity goes back to 0, so every later draw tries again
+// and falls back to DrawPixels until one works
+static bool ReserveVertices(ParticleRenderer *renderer, int count) {
+    if (count <= renderer->vertexCapacity) return true;
+    int capacity = renderer->vertexCapacity > 0 ? renderer->vertexCapacity : 256;
+    while (capacity < count && capacity <= INT_MAX / 2) capacity *= 2;
+    const size_t bytes = (size_t)capacity * FloatsPerParticle(renderer) * sizeof(float);
+    // rlgl sizes buffers with an int
+    if (capacity < count || bytes > INT_MAX) return false;
+    float *staging = realloc(renderer->staging, bytes);
+    if (staging == NULL) return false;
+    renderer->staging = staging;
+    if (renderer->vertexVbo != 0) rlUnloadVertexBuffer(renderer->vertexVbo);
+    renderer->vertexVbo = rlLoadVertexBuffer(NULL, (int)bytes, true);
+    renderer->vertexCapacity = renderer->vertexVbo != 0 ? capacity : 0;
+    return renderer->vertexVbo != 0;
+}
+
+static int PackVertices(ParticleRenderer *renderer, const ParticleStore *store, Vector2 drift) {
+    float *out = renderer->staging;
+    if (renderer->mode == ParticleRenderInstanced) {
+        for (int i = 0; i < store->count; i++) {
+            out[0] = store->x[i] + store->value[i] * drift.x;
+            out[1] = store->y[i] + store->value[i] * drift.y;
+            out += INSTANCED_FLOATS;
+        }
+    } else {
+        for (int i = 0; i < store->count; i++) {
+            const float x = store->x[i] + store->value[i] * drift.x;
+            const float y = store->y[i] + store->value[i] * drift.y;
+            for (int v = 0; v < 12; v += 2) {
+                out[v] = x + unitQuad[v];
+                out[v + 1] = y + unitQuad[v + 1];
+            }
+            out += EXPANDED_FLOATS;
+        }
+    }
+    return store->count * FloatsPerParticle(renderer) * (int)sizeof(float);
+}
+
+static void DrawPixels(const ParticleStore *store, Vector2 drift, Color color) {
+    for (int i = 0; i < store->count; i++) {
+        DrawPixelV((Vector2){store->x[i] + store->value[i] * drift.x, store->y[i] + store->value[i] * drift.y}, color);
+    }
+}
+
+void DrawParticles(ParticleRenderer *renderer, const ParticleStore *store, Vector2 drift, Color color) {
+    if (store->count == 0) return;
+    if (renderer == NULL || renderer->mode == ParticleRenderPixels || !ReserveVertices(renderer, store->count)) {
+        DrawPixels(store, drift, color);
+        return;
+    }
+    // Whatever is queued in raylib's batch must land before our draw
+    rlDrawRenderBatchActive();
+    rlUpdateVertexBuffer(renderer->vertexVbo, renderer->staging, PackVertices(renderer, store, drift), 0);
+
+    const float tint[4] = { color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f };
+    rlEnableShader(renderer->shader.id);
+    rlSetUniformMatrix(renderer->mvpLoc, MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+    rlSetUniform(renderer->colorLoc, tint, RL_SHADER_UNIFORM_VEC4, 1);
+    rlEnableVertexArray(renderer->vao);
+
+    const unsigned int positionLoc = renderer->shader.locs[SHADER_LOC_VERTEX_POSITION];
+    if (renderer->mode == ParticleRenderInstanced) {
+        rlEnableVertexBuffer(renderer->quadVbo);
+        rlSetVertexAttribute(positionLoc, 2, RL_FLOAT, false, 0, 0);
+        rlEnableVertexAttribute(positionLoc);
+        rlEnableVertexBuffer(renderer->vertexVbo);
+        rlSetVertexAttribute(renderer->offsetLoc, 2, RL_FLOAT, false, 0, 0);
+        rlSetVertexAttributeDivisor(renderer->offsetLoc, 1);
+        rlEnableVertexAttribute(renderer->offsetLoc);
+        rlDrawVertexArrayInstanced(0, 6, store->count);
+        rlDisableVertexAttribute(renderer->offsetLoc);
+    } else {
+        rlEnableVertexBuffer(renderer->vertexVbo);
+        rlSetVertexAttribute(positionLoc, 2, RL_FLOAT, false, 0, 0);
+        rlEnableVertexAttribute(positionLoc);
+        rlDrawVertexArray(0, store->count * 6);
+    }
+    rlDisableVertexAttribute(positionLoc);
+
+    rlDisableVertexBuffer();
+    rlDisableVertexArray();
+    rlDisableShader();
+}
@@ -0,0 +1,40 @@
+#ifndef PIXEL_BLOOM_PARTICLE_RENDERER_H
+#define PIXEL_BLOOM_PARTICLE_RENDERER_H
+
+// Draws whole particle stores as 1x1 quads with a single draw call. All
+// positions go up in one vertex buffer per frame: instanced quads on GL 3.3 /
+// GLES 3 (WebGL 2), or CPU-expanded triangles on GL 2.1 / GLES 2 (WebGL 1).
+// Falls back to one DrawPixelV per particle when neither is available.
+
+#include "raylib.h"
+#include "particles.h"
+
+typedef enum ParticleRenderMode {
+    ParticleRenderAuto = 0,      // best mode the GL context supports
+    ParticleRenderInstanced = 1,
+    ParticleRenderExpanded = 2,
+    ParticleRenderPixels = 3,    // DrawPixelV per particle
+} ParticleRenderMode;
+
+typedef struct ParticleRenderer {
+    ParticleRenderMode mode;
+    Shader shader;
+    int mvpLoc;
+    int colorLoc;
+    int offsetLoc;              // instanceOffset attribute, instanced mode only
+    unsigned int vao;           // 0 where vertex array objects aren't supported
+    unsigned int quadVbo;       // unit quad, instanced mode only
+    unsigned int vertexVbo;     // per-frame positions
+    int vertexCapacity;         // particles the vertex buffer holds
+    float *staging;
+} ParticleRenderer;
+
+// Falls back to ParticleRenderPixels when the requested mode can't be set up
+void ParticleRendererInit(ParticleRenderer *renderer, ParticleRenderMode mode);
+void ParticleRendererFree(ParticleRenderer *renderer);
+// Call between BeginTextureMode/EndTextureMode (or BeginDrawing/EndDrawing).
+// Every particle is drawn at its position + value * drift, which is how
+// frames between two ticks interpolate: particles move value-proportionally
+void DrawParticles(ParticleRenderer *renderer, const ParticleStore *store, Vector2 drift, Color color);
+
+#endif // PIXEL_BLOOM_PARTICLE_RENDERER_H
@@ -0,0 +1,204 @@
+#include "particles.h"
+#include "simd.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Enough for AVX2 loads to never split a cache line at the start of a lane
+#define PARTICLE_ALIGNMENT 32
+
+static void *AllocLane(size_t bytes) {
+    bytes = (bytes + PARTICLE_ALIGNMENT - 1) & ~(size_t)(PARTICLE_ALIGNMENT - 1);
+#if defined(_MSC_VER)
+    return _aligned_malloc(bytes, PARTICLE_ALIGNMENT);
+#else
+    return aligned_alloc(PARTICLE_ALIGNMENT, bytes);
+#endif
+}
+
+static void FreeLane(void *lane) {
+#if defined(_MSC_VER)
+    _aligned_free(lane);
+#else
+    free(lane);
+#endif
+}
+
+bool ParticleStoreInit(ParticleStore *store, int capacity) {
+    *store = (ParticleStore){0};
+    if (capacity <= 0) return false;
+    store->x = AllocLane(sizeof(float) * capacity);
+    store->y = AllocLane(sizeof(float) * capacity);
+    store->value = AllocLane(sizeof(float) * capacity);
+    store->hits = AllocLane(sizeof(uint8_t) * capacity);
+    store->spareX = AllocLane(sizeof(float) * capacity);
+    store->spareY = AllocLane(sizeof(float) * capacity);
+    store->spareValue = AllocLane(sizeof(float) * capacity);
+    store->spareHits = AllocLane(sizeof(uint8_t) * capacity);
+    if (store->x == NULL || store->y == NULL || store->value == NULL || store->hits == NULL ||
+        store->spareX == NULL || store->spareY == NULL || store->spareValue == NULL || store->spareHits == NULL) {
+        ParticleStoreFree(store);
+        return false;
+    }
+    memset(store->hits, 0, sizeof(uint8_t) * capacity);
+    store->capacity = capacity;
+    return true;
+}
+
+void ParticleStoreFree(ParticleStore *store) {
+    FreeLane(store->x);
+    FreeLane(store->y);
+    FreeLane(store->value);
+    FreeLane(store->hits);
+    FreeLane(store->spareX);
+    FreeLane(store->spareY);
+    FreeLane(store->spareValue);
+    FreeLane(store->spareHits);
+    *store = (ParticleStore){0};
+}
+
+bool ParticleStorePush(ParticleStore *store, float x, float y, float value) {
+    if (store->count >= store->capacity) return false;
+    store->x[store->count] = x;
+    store->y[store->count] = y;
+    store->value[store->count] = value;
+    store->hits[store->count] = ParticleHitNone;
+    store->count += 1;
+    return true;
+}
+
+void ParticlesIntegrate(float *lane, const float *value, float scale, int begin, int end) {
+    int i = begin;
+#if !defined(SIMD_SCALAR)
+    const SimdFloat step = SimdSet1(scale);
+    for (; i + SIMD_WIDTH <= end; i += SIMD_WIDTH) {
+        SimdStore(lane + i, SimdAdd(SimdLoad(lane + i), SimdMul(SimdLoad(value + i), step)));
+    }
+#endif
+    for (; i < end; i++) {
+        lane[i] += value[i] * scale;
+    }
+}
+
+static uint8_t ClassifyOne(float position, float limit, bool shielding, float dx, float dy, float radius2) {
+    if (position > limit) return ParticleHitGround;
+    if (shielding && dx * dx + dy * dy <= radius2) return ParticleHitShield;
+    return ParticleHitNone;
+}
+
+// Position within its tile, truncation being floor for non-negative positions
+static float TileOffset(float position, float tile, float inverse) {
+    return position - (float)(int)(position * inverse) * tile;
+}
+
+// tile 0 tests the position itself
+static ParticleHitCount Classify(ParticleStore *store, const float *lane, float tile, float limit,
+    bool shielding, float shieldX, float shieldY, float radius, int begin, int end) {
+    ParticleHitCount count = {0};
+    const float radius2 = radius * radius;
+    const bool tiled = tile > 0;
+    const float inverse = tiled ? 1 / tile : 0;
+    uint8_t *hits = store->hits;
+    int i = begin;
+#if !defined(SIMD_SCALAR)
+    const SimdFloat limitV = SimdSet1(limit);
+    const SimdFloat tileV = SimdSet1(tile);
+    const SimdFloat inverseV = SimdSet1(inverse);
+    const SimdFloat shieldXV = SimdSet1(shieldX);
+    const SimdFloat shieldYV = SimdSet1(shieldY);
+    const SimdFloat radius2V = SimdSet1(radius2);
+    for (; i + SIMD_WIDTH <= end; i += SIMD_WIDTH) {
+        SimdFloat position = SimdLoad(lane + i);
+        if (tiled) {
+            position = SimdSub(position, SimdMul(SimdTruncate(SimdMul(position, inverseV)), tileV));
+        }
+        const SimdFloat ground = SimdGreater(position, limitV);
+        int groundBits = SimdMaskBits(ground);
+        int shieldBits = 0;
+        if (shielding) {
+            const SimdFloat dx = SimdSub(SimdLoad(store->x + i), shieldXV);
+            const SimdFloat dy = SimdSub(SimdLoad(store->y + i), shieldYV);
+            const SimdFloat dist2 = SimdAdd(SimdMul(dx, dx), SimdMul(dy, dy));
+            shieldBits = SimdMaskBits(SimdAndNot(SimdLessEqual(dist2, radius2V), ground));
+        }
+        if ((groundBits | shieldBits) == 0) {
+            memset(hits + i, ParticleHitNone, SIMD_WIDTH);
+            continue;
+        }
+        for (int k = 0; k < SIMD_WIDTH; k++) {
+            hits[i + k] = (uint8_t)(((groundBits >> k) & 1) | (((shieldBits >> k) & 1) << 1));
+        }
+        for (; groundBits != 0; groundBits &= groundBits - 1) count.ground++;
+        for (; shieldBits != 0; shieldBits &= shieldBits - 1) count.shield++;
+    }
+#endif
+    for (; i < end; i++) {
+        const float position = tiled ? TileOffset(lane[i], tile, inverse) : lane[i];
+        hits[i] = ClassifyOne(position, limit, shielding, store->x[i] - shieldX, store->y[i] - shieldY, radius2);
+        count.ground += hits[i] == ParticleHitGround;
+        count.shield += hits[i] == ParticleHitShield;
+    }
+    return count;
+}
+
+ParticleHitCount ParticlesClassify(ParticleStore *store, const float *lane, float limit,
+    bool shielding, float shieldX, float shieldY, float radius, int begin, int end) {
+    return Classify(store, lane, 0, limit, shielding, shieldX, shieldY, radius, begin, end);
+}
+
+ParticleHitCount ParticlesClassifyTiled(ParticleStore *store, const float *lane, float tile, float limit,
+    bool shielding, float shieldX, float shieldY, float radius, int begin, int end) {
+    return Classify(store, lane, tile, limit, shielding, shieldX, shieldY, radius, begin, end);
+}
+
+int ParticlesCompact(ParticleStore *store) {
+    int write = 0;
+    for (int read = 0; read < store->count; read++) {
+        // Branchless: always copy, only advance past survivors
+        store->x[write] = store->x[read];
+        store->y[write] = store->y[read];
+        store->value[write] = store->value[read];
+        write += store->hits[read] == ParticleHitNone;
+    }
+    memset(store->hits, ParticleHitNone, write);
+    store->count = write;
+    return write;
+}
+
+int ParticlesCountSurvivors(const ParticleStore *store, int begin, int end) {
+    int survivors = 0;
+    for (int i = begin; i < end; i++) {
+        survivors += store->hits[i] == ParticleHitNone;
+    }
+    return survivors;
+}
+
+void ParticlesCompactRange(ParticleStore *store, int begin, int end, int offset) {
+    int write = offset;
+    for (int read = begin; read < end; read++) {
+        // Not branchless like ParticlesCompact: the slot past the last
+        // survivor belongs to the next range
+        if (store->hits[read] != ParticleHitNone) continue;
+        store->spareX[write] = store->x[read];
+        store->spareY[write] = store->y[read];
+        store->spareValue[write] = store->value[read];
+        write++;
+    }
+    memset(store->spareHits + offset, ParticleHitNone, write - offset);
+}
+
+static void SwapLanes(float **a, float **b) {
+    float *lane = *a;
+    *a = *b;
+    *b = lane;
+}
+
+void ParticlesSwapSpare(ParticleStore *store, int count) {
+    SwapLanes(&store->x, &store->spareX);
+    SwapLanes(&store->y, &store->spareY);
+    SwapLanes(&store->value, &store->spareValue);
+    uint8_t *hits = store->hits;
+    store->hits = store->spareHits;
+    store->spareHits = hits;
+    store->count = count;
+}
@@ -0,0 +1,62 @@
+#ifndef PIXEL_BLOOM_PARTICLES_H
+#define PIXEL_BLOOM_PARTICLES_H
+
+// Structure-of-arrays particle store. Each tick runs three separate passes
+// over it: integrate one position lane, classify every particle against the
+// ground line and the shield, then compact the survivors. The first two are
+// vectorized (see simd.h), and every pass works on a [begin, end) range so
+// it can be split into chunks. Compaction in chunks copies the survivors out
+// to the spare lanes, which then become the live ones.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum ParticleHit {
+    ParticleHitNone = 0,
+    ParticleHitGround = 1,  // reached the flower, to be applied then removed
+    ParticleHitShield = 2,  // blocked by the shield, removed
+} ParticleHit;
+
+typedef struct ParticleStore {
+    float *x;
+    float *y;
+    float *value;     // wind power or water amount
+    uint8_t *hits;    // ParticleHit per particle, written by ParticlesClassify
+    float *spareX;    // destination of ParticlesCompactRange
+    float *spareY;
+    float *spareValue;
+    uint8_t *spareHits;
+    int count;
+    int capacity;
+} ParticleStore;
+
+typedef struct ParticleHitCount {
+    int ground;
+    int shield;
+} ParticleHitCount;
+
+bool ParticleStoreInit(ParticleStore *store, int capacity);
+void ParticleStoreFree(ParticleStore *store);
+// Returns false when the store is full
+bool ParticleStorePush(ParticleStore *store, float x, float y, float value);
+
+// lane[i] += value[i] * scale
+void ParticlesIntegrate(float *lane, const float *value, float scale, int begin, int end);
+// Marks particles whose lane is past limit as ground hits, otherwise the ones
+// inside the shield (when shielding) as shield hits
+ParticleHitCount ParticlesClassify(ParticleStore *store, const float *lane, float limit,
+    bool shielding, float shieldX, float shieldY, float radius, int begin, int end);
+// Same, with the limit tested on the lane's position within its tile of the
+// given size: one ground line per tile, for lanes that are never negative
+ParticleHitCount ParticlesClassifyTiled(ParticleStore *store, const float *lane, float tile, float limit,
+    bool shielding, float shieldX, float shieldY, float radius, int begin, int end);
+// Stable in-place removal of every particle with a hit, returns the new count
+int ParticlesCompact(ParticleStore *store);
+// Particles in [begin, end) without a hit
+int ParticlesCountSurvivors(const ParticleStore *store, int begin, int end);
+// Copies the survivors of [begin, end) to the spare lanes from offset on
+void ParticlesCompactRange(ParticleStore *store, int begin, int end, int offset);
+// Swaps the spare lanes in once every range went through ParticlesCompactRange
+void ParticlesSwapSpare(ParticleStore *store, int count);
+
+#endif // PIXEL_BLOOM_PARTICLES_H
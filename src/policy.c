@@ -0,0 +1,88 @@
+#include "policy.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+bool PolicyParse(const char *text, Policy *policy) {
+    if (strcmp(text, "idle") == 0) {
+        *policy = (Policy){ PolicyIdle, 0 };
+        return true;
+    }
+    if (strcmp(text, "bot") == 0) {
+        *policy = (Policy){ PolicyBot, 0 };
+        return true;
+    }
+    if (strncmp(text, "cycle:", 6) == 0) {
+        char *end;
+        const float seconds = strtof(text + 6, &end);
+        if (end == text + 6 || *end != '\0' || !(seconds > 0)) return false;
+        *policy = (Policy){ PolicyCycle, seconds };
+        return true;
+    }
+    return false;
+}
+
+static Input BotInput(const Game *game) {
+    Input input = {0};
+    // A garden is watered for its average flower
+    const float waterLevel = game->garden.count > 0 ? game->garden.meanWaterLevel : game->flower.waterLevel;
+    if (game->isSunUp && waterLevel < FLOWER_MAX_WATER_LEVEL * 0.3f) {
+        input.toggleWeather = true;
+    } else if (!game->isSunUp && waterLevel > FLOWER_MAX_WATER_LEVEL * 0.7f) {
+        input.toggleWeather = true;
+    }
+    if (game->weather.wind != NULL) {
+        // Field weather: park the shield on the gust closest to the flower,
+        // the strongest cell of the first column past a trace of wind
+        int gustX = -1;
+        int gustY = -1;
+        for (int x = FLOWER_LINE; x >= 0 && gustX < 0; x--) {
+            float strongest = 1;
+            for (int y = 0; y < NATIVE_HEIGHT; y++) {
+                const float wind = game->weather.wind[WeatherCell(x, y)];
+                if (wind > strongest) {
+                    strongest = wind;
+                    gustX = x;
+                    gustY = y;
+                }
+            }
+        }
+        if (game->isSunUp && gustX >= 0) {
+            input.shieldPosition = (Vector2){ gustX + 0.5f, gustY + 0.5f };
+            input.shieldPressed = !game->isShielding;
+        } else {
+            input.shieldReleased = game->isShielding;
+        }
+        return input;
+    }
+    // Park the shield on the wind particle closest to the flower
+    int closest = -1;
+    for (int i = 0; i < game->wind.count; i++) {
+        if (closest < 0 || game->wind.x[i] > game->wind.x[closest]) {
+            closest = i;
+        }
+    }
+    if (game->isSunUp && closest >= 0) {
+        input.shieldPosition = (Vector2){game->wind.x[closest], game->wind.y[closest]};
+        input.shieldPressed = !game->isShielding;
+    } else {
+        input.shieldReleased = game->isShielding;
+    }
+    return input;
+}
+
+Input PolicyInput(Policy policy, const Game *game, long long tick, float delta) {
+    switch (policy.type) {
+        case PolicyBot:
+            return BotInput(game);
+        case PolicyCycle:
+            {
+                // In ticks, so the period doesn't drift with float sums
+                long long period = (long long)(policy.cycleSeconds / delta + 0.5f);
+                if (period < 1) period = 1;
+                return (Input){ .toggleWeather = tick > 0 && tick % period == 0 };
+            }
+        default:
+            return (Input){0};
+    }
+}
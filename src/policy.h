@@ -0,0 +1,27 @@
+#ifndef PIXEL_BLOOM_POLICY_H
+#define PIXEL_BLOOM_POLICY_H
+
+// Scripted players for the headless tools. Every policy is a pure function of
+// the game state and the tick, so sessions driven by one stay deterministic.
+
+#include <stdbool.h>
+
+#include "sim.h"
+
+typedef enum PolicyType {
+    PolicyIdle = 0,   // never touches anything
+    PolicyBot = 1,    // keeps the water level in range and shields the wind
+    PolicyCycle = 2,  // toggles the weather every cycleSeconds, never shields
+} PolicyType;
+
+typedef struct Policy {
+    PolicyType type;
+    float cycleSeconds;
+} Policy;
+
+// "idle", "bot" or "cycle:SECONDS", returns false for anything else
+bool PolicyParse(const char *text, Policy *policy);
+// Input for the tick'th SimStep of a session, each delta seconds long
+Input PolicyInput(Policy policy, const Game *game, long long tick, float delta);
+
+#endif // PIXEL_BLOOM_POLICY_H
@@ -0,0 +1,203 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+#endif
+
+#include "profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__EMSCRIPTEN__)
+#include <emscripten/emscripten.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(_MSC_VER)
+#define PROFILER_THREAD_LOCAL __declspec(thread)
+#else
+#define PROFILER_THREAD_LOCAL _Thread_local
+#endif
+
+typedef struct ProfileEvent {
+    const char *name;
+    uint64_t start;
+    uint32_t duration;          // nanoseconds
+    uint32_t thread;
+    atomic_uint_fast64_t sequence; // ring index + 1 once the event is complete
+} ProfileEvent;
+
+atomic_bool profilerEnabled = false;
+
+static ProfileEvent ring[PROFILER_RING_SIZE];
+static atomic_uint_fast64_t ringHead = 0;
+static atomic_int threadCount = 0;
+static PROFILER_THREAD_LOCAL int threadIndex = -1;
+
+// Main thread only, see ProfilerFrameEnd
+static uint64_t lastFrameEnd = 0;
+static uint64_t folded = 0;     // ring events already added to the histories
+static float frameHistory[PROFILER_HISTORY];
+static const char *phaseNames[PROFILER_MAX_PHASES];
+static float phaseHistory[PROFILER_MAX_PHASES][PROFILER_HISTORY];
+static int phaseCount = 0;
+static int historyNext = 0;
+static int historyCount = 0;
+
+uint64_t ProfilerNow(void) {
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency = {0};
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000000u +
+        (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000000u / frequency.QuadPart;
+#elif defined(__EMSCRIPTEN__)
+    return (uint64_t)(emscripten_get_now() * 1e6);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+
+static int ThreadIndex(void) {
+    if (threadIndex < 0) threadIndex = atomic_fetch_add(&threadCount, 1);
+    return threadIndex;
+}
+
+void ProfilerSetEnabled(bool enabled) {
+    // The caller is the main thread, so it shows up as thread 0 in traces
+    ThreadIndex();
+    if (enabled && !atomic_load(&profilerEnabled)) {
+        lastFrameEnd = ProfilerNow();
+        folded = atomic_load(&ringHead);
+    }
+    atomic_store(&profilerEnabled, enabled);
+}
+
+void ProfilerRecord(const char *name, uint64_t start, uint64_t end) {
+    const uint64_t index = atomic_fetch_add_explicit(&ringHead, 1, memory_order_relaxed);
+    ProfileEvent *event = &ring[index & (PROFILER_RING_SIZE - 1)];
+    atomic_store_explicit(&event->sequence, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    event->name = name;
+    event->start = start;
+    event->duration = (end - start) > UINT32_MAX ? UINT32_MAX : (uint32_t)(end - start);
+    event->thread = (uint32_t)ThreadIndex();
+    atomic_store_explicit(&event->sequence, index + 1, memory_order_release);
+}
+
+// Seqlock read: false when the slot is mid-write or already reused
+static bool ReadEvent(uint64_t index, ProfileEvent *copy) {
+    const ProfileEvent *event = &ring[index & (PROFILER_RING_SIZE - 1)];
+    if (atomic_load_explicit(&event->sequence, memory_order_acquire) != index + 1) return false;
+    copy->name = event->name;
+    copy->start = event->start;
+    copy->duration = event->duration;
+    copy->thread = event->thread;
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&event->sequence, memory_order_relaxed) == index + 1;
+}
+
+static int PhaseIndex(const char *name) {
+    for (int i = 0; i < phaseCount; i++) {
+        if (phaseNames[i] == name || strcmp(phaseNames[i], name) == 0) return i;
+    }
+    if (phaseCount == PROFILER_MAX_PHASES) return -1;
+    // A phase first seen now had zero time in the frames before
+    memset(phaseHistory[phaseCount], 0, sizeof(phaseHistory[phaseCount]));
+    phaseNames[phaseCount] = name;
+    return phaseCount++;
+}
+
+void ProfilerFrameEnd(void) {
+    if (!atomic_load_explicit(&profilerEnabled, memory_order_relaxed)) return;
+    const uint64_t now = ProfilerNow();
+    const uint64_t head = atomic_load(&ringHead);
+    if (head - folded > PROFILER_RING_SIZE) folded = head - PROFILER_RING_SIZE;
+
+    float totals[PROFILER_MAX_PHASES] = {0};
+    for (; folded < head; folded++) {
+        ProfileEvent event;
+        if (!ReadEvent(folded, &event)) continue;
+        const int phase = PhaseIndex(event.name);
+        if (phase >= 0) totals[phase] += event.duration / 1e6f;
+    }
+    frameHistory[historyNext] = (now - lastFrameEnd) / 1e6f;
+    for (int i = 0; i < phaseCount; i++) {
+        phaseHistory[i][historyNext] = totals[i];
+    }
+    historyNext = (historyNext + 1) % PROFILER_HISTORY;
+    if (historyCount < PROFILER_HISTORY) historyCount++;
+    lastFrameEnd = now;
+}
+
+static int CompareFloats(const void *a, const void *b) {
+    const float left = *(const float *)a;
+    const float right = *(const float *)b;
+    return (left > right) - (left < right);
+}
+
+ProfileStats ProfilerPercentiles(const float *history, int count, const char *name) {
+    ProfileStats stats = { .name = name };
+    if (count <= 0) return stats;
+    float *sorted = malloc(sizeof(float) * count);
+    if (sorted == NULL) return stats;
+    memcpy(sorted, history, sizeof(float) * count);
+    qsort(sorted, count, sizeof(float), CompareFloats);
+    stats.p50 = sorted[(count - 1) * 50 / 100];
+    stats.p95 = sorted[(count - 1) * 95 / 100];
+    stats.p99 = sorted[(count - 1) * 99 / 100];
+    stats.max = sorted[count - 1];
+    free(sorted);
+    return stats;
+}
+
+ProfileStats ProfilerFrameStats(void) {
+    return ProfilerPercentiles(frameHistory, historyCount, "frame");
+}
+
+int ProfilerPhaseStats(ProfileStats *stats, int capacity) {
+    const int count = phaseCount < capacity ? phaseCount : capacity;
+    for (int i = 0; i < count; i++) {
+        stats[i] = ProfilerPercentiles(phaseHistory[i], historyCount, phaseNames[i]);
+    }
+    return count;
+}
+
+bool ProfilerWriteChromeTrace(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) return false;
+    const uint64_t head = atomic_load(&ringHead);
+    const uint64_t first = head > PROFILER_RING_SIZE ? head - PROFILER_RING_SIZE : 0;
+    uint64_t origin = UINT64_MAX;
+    for (uint64_t i = first; i < head; i++) {
+        ProfileEvent event;
+        if (ReadEvent(i, &event) && event.start < origin) origin = event.start;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    const int threads = atomic_load(&threadCount);
+    for (int t = 0; t < threads; t++) {
+        fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}},\n",
+            t, t == 0 ? "main" : "worker", t);
+    }
+    bool firstEvent = true;
+    for (uint64_t i = first; i < head; i++) {
+        ProfileEvent event;
+        if (!ReadEvent(i, &event)) continue;
+        fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+            firstEvent ? "" : ",\n", event.name, event.thread, (event.start - origin) / 1e3, event.duration / 1e3);
+        firstEvent = false;
+    }
+    // The metadata lines end in commas, so the array needs one more entry
+    if (firstEvent) fprintf(file, "{\"name\":\"empty\",\"ph\":\"i\",\"pid\":1,\"tid\":0,\"ts\":0}");
+    fprintf(file, "\n]}\n");
+    const bool ok = ferror(file) == 0;
+    return fclose(file) == 0 && ok;
+}
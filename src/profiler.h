@@ -0,0 +1,77 @@
+#ifndef PIXEL_BLOOM_PROFILER_H
+#define PIXEL_BLOOM_PROFILER_H
+
+// Scoped phase timers. PROFILE_BEGIN/PROFILE_END record one event into a
+// lock-free ring any thread can write to; while the profiler is disabled they
+// cost one relaxed load and a branch, and building with
+// -DPIXEL_BLOOM_PROFILER=OFF compiles them out. ProfilerFrameEnd folds the
+// frame's events into per-phase histories for percentile stats, and the ring
+// can be dumped as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+//
+//     PROFILE_BEGIN(sim, "sim");
+//     SimStep(...);
+//     PROFILE_END(sim);
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef PIXEL_BLOOM_PROFILER
+#define PIXEL_BLOOM_PROFILER 1
+#endif
+
+#define PROFILER_RING_SIZE 16384    // events, power of two
+#define PROFILER_HISTORY 240        // frames the percentiles cover
+#define PROFILER_MAX_PHASES 16
+
+typedef struct ProfileZone {
+    const char *name;   // NULL when the profiler was off at PROFILE_BEGIN
+    uint64_t start;
+} ProfileZone;
+
+typedef struct ProfileStats {
+    const char *name;
+    float p50;          // milliseconds
+    float p95;
+    float p99;
+    float max;
+} ProfileStats;
+
+extern atomic_bool profilerEnabled;
+
+// Monotonic nanoseconds
+uint64_t ProfilerNow(void);
+void ProfilerSetEnabled(bool enabled);
+void ProfilerRecord(const char *name, uint64_t start, uint64_t end);
+
+static inline ProfileZone ProfileBegin(const char *name) {
+    if (!atomic_load_explicit(&profilerEnabled, memory_order_relaxed)) return (ProfileZone){0};
+    return (ProfileZone){ name, ProfilerNow() };
+}
+
+static inline void ProfileEnd(ProfileZone zone) {
+    if (zone.name != NULL) ProfilerRecord(zone.name, zone.start, ProfilerNow());
+}
+
+#if PIXEL_BLOOM_PROFILER
+#define PROFILE_BEGIN(zone, name) const ProfileZone zone = ProfileBegin(name)
+#define PROFILE_END(zone) ProfileEnd(zone)
+#else
+#define PROFILE_BEGIN(zone, name) ((void)0)
+#define PROFILE_END(zone) ((void)0)
+#endif
+
+// Call once per frame (or tick) from the main thread
+void ProfilerFrameEnd(void);
+// Frame to frame times over the last PROFILER_HISTORY frames
+ProfileStats ProfilerFrameStats(void);
+// Per-frame totals of every phase seen so far, returns how many were written
+int ProfilerPhaseStats(ProfileStats *stats, int capacity);
+// Percentiles of count samples in any order, in milliseconds. Zero when
+// there are none
+ProfileStats ProfilerPercentiles(const float *history, int count, const char *name);
+// Writes the events still in the ring, returns false when the file can't be written
+bool ProfilerWriteChromeTrace(const char *path);
+
+#endif // PIXEL_BLOOM_PROFILER_H
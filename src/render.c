@@ -0,0 +1,163 @@
+#include "render.h"
+#include "profiler.h"
+#include "soft_render.h"
+#include "rlgl.h"
+
+static const int DEFAULT_BAR_HEIGHT = 40;
+// Garden plots have their bars in the top left corner, out of the wind and rain
+static const int GARDEN_BAR_HEIGHT = 20;
+
+// Field weather, rasterized on the CPU like the soft renderer does
+static uint8_t weatherPixels[NATIVE_WIDTH * NATIVE_HEIGHT * 4];
+
+void LoadGameTextures(GameTextures *textures) {
+    textures->atlas = LoadAtlasTexture();
+    // raylib clamps the HUD's size 1 to its smallest font anyway
+    textures->score = UiLabel("$: 000", 1, WHITE);
+    WidgetSetBounds(&textures->score, (Rectangle){NATIVE_WIDTH - 30, DEFAULT_BAR_HEIGHT-30});
+    textures->shownScore = 0;
+    const Image weather = {
+        .data = weatherPixels,
+        .width = NATIVE_WIDTH,
+        .height = NATIVE_HEIGHT,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+    };
+    textures->weather = LoadTextureFromImage(weather);
+    Rectangle white = AtlasFrame(SpriteWhite, 0);
+    SetShapesTexture(textures->atlas, (Rectangle){ white.x + 1, white.y + 1, 1, 1 });
+}
+
+void UnloadGameTextures(GameTextures *textures) {
+    if(textures->atlas.id != 0) {
+        SetShapesTexture((Texture2D){0}, (Rectangle){0});
+        UnloadTexture(textures->atlas);
+    }
+    if (textures->weather.id != 0) UnloadTexture(textures->weather);
+    WidgetUnload(&textures->score);
+    *textures = (GameTextures){0};
+}
+
+void DrawNativeFrame(RenderTexture2D target, const Game *game, GameTextures *textures, ParticleRenderer *particles, float lag, bool shields) {
+    const int score = (int)(game->score + 0.5f);
+    if (score != textures->shownScore) {
+        textures->shownScore = score;
+        WidgetSetText(&textures->score, TextFormat("$: %03d", score));
+    }
+    WidgetRefresh(&textures->score);
+
+    BeginTextureMode(target);
+        ClearBackground(DARKGRAY);
+        if (game->weather.wind != NULL) {
+            SoftRenderWeather(weatherPixels, game);
+            UpdateTexture(textures->weather, weatherPixels);
+            DrawTexture(textures->weather, 0, 0, WHITE);
+        }
+        if (game->isSunUp) {
+            DrawParticles(particles, &game->wind, (Vector2){ -lag, 0 }, RAYWHITE);
+            DrawTextureRec(textures->atlas, AtlasFrame(SpriteSun, game->sun.currentFrame), (Vector2){0, 0}, WHITE);
+        } else {
+            DrawParticles(particles, &game->water, (Vector2){ 0, -WATER_FALL_SPEED * lag }, RAYWHITE);
+            DrawTextureRec(textures->atlas, AtlasFrame(SpriteCloud, game->cloud.currentFrame), (Vector2){40, 0}, WHITE);
+        }
+        const Rectangle flowerFrame = AtlasFrame(SpriteFlower, game->flower.currentFrame);
+        DrawTextureRec(textures->atlas, flowerFrame, (Vector2){60, NATIVE_HEIGHT - flowerFrame.height}, WHITE);
+
+        const float healthHeight = DEFAULT_BAR_HEIGHT*game->flower.health/100;
+        const float hidrationHeight = DEFAULT_BAR_HEIGHT*game->flower.waterLevel/FLOWER_MAX_WATER_LEVEL;
+        const Rectangle healthRec = (Rectangle){NATIVE_WIDTH-20, NATIVE_HEIGHT-healthHeight, 4, healthHeight};
+        const Rectangle hidrationRec = (Rectangle){NATIVE_WIDTH-10, NATIVE_HEIGHT-hidrationHeight, 4, hidrationHeight};
+        DrawRectangleRec(healthRec, WHITE);
+        DrawRectangleRec(hidrationRec, WHITE);
+        DrawTextureRec(textures->atlas, AtlasFrame(SpriteHealth, 0), (Vector2){healthRec.x-2, NATIVE_HEIGHT - DEFAULT_BAR_HEIGHT - 10}, WHITE);
+        DrawTextureRec(textures->atlas, AtlasFrame(SpriteWater, 0), (Vector2){hidrationRec.x-2, NATIVE_HEIGHT - DEFAULT_BAR_HEIGHT - 10}, WHITE);
+        WidgetDraw(&textures->score);
+
+        for (int i = 0; shields && i < game->shieldCount; i++) {
+            DrawCircleV(game->shields[i], SHIELD_RADIUS, LIGHTGRAY);
+        }
+    EndTextureMode();
+}
+
+// One textured quad into raylib's batch, which starts a new draw call by itself
+// when it fills up
+static void BatchQuad(Rectangle source, Rectangle dest, Vector2 texel) {
+    const float left = source.x * texel.x;
+    const float right = (source.x + source.width) * texel.x;
+    const float top = source.y * texel.y;
+    const float bottom = (source.y + source.height) * texel.y;
+    rlTexCoord2f(left, top);
+    rlVertex2f(dest.x, dest.y);
+    rlTexCoord2f(left, bottom);
+    rlVertex2f(dest.x, dest.y + dest.height);
+    rlTexCoord2f(right, bottom);
+    rlVertex2f(dest.x + dest.width, dest.y + dest.height);
+    rlTexCoord2f(right, top);
+    rlVertex2f(dest.x + dest.width, dest.y);
+}
+
+void DrawGardenFrame(const Game *game, const GameTextures *textures, ParticleRenderer *particles, float lag) {
+    const Garden *garden = &game->garden;
+    ClearBackground(DARKGRAY);
+    if (game->isSunUp) {
+        DrawParticles(particles, &game->wind, (Vector2){ -lag, 0 }, RAYWHITE);
+    } else {
+        DrawParticles(particles, &game->water, (Vector2){ 0, -WATER_FALL_SPEED * lag }, RAYWHITE);
+    }
+
+    Rectangle frames[FLOWER_FRAMES];
+    for (int i = 0; i < FLOWER_FRAMES; i++) {
+        frames[i] = AtlasFrame(SpriteFlower, i);
+    }
+    const Rectangle white = AtlasFrame(SpriteWhite, 0);
+    const Rectangle pixel = { white.x + 1, white.y + 1, 1, 1 };
+    const Vector2 texel = { 1.0f / textures->atlas.width, 1.0f / textures->atlas.height };
+    rlSetTexture(textures->atlas.id);
+    rlBegin(RL_QUADS);
+    rlNormal3f(0, 0, 1);
+    for (int i = 0; i < garden->count; i++) {
+        const float x = (float)((i % garden->columns) * GARDEN_PLOT_WIDTH);
+        const float y = (float)((i / garden->columns) * GARDEN_PLOT_HEIGHT);
+        const Rectangle frame = frames[garden->currentFrame[i]];
+        if (garden->isAlive[i]) {
+            rlColor4ub(255, 255, 255, 255);
+        } else {
+            rlColor4ub(90, 90, 90, 255);
+        }
+        BatchQuad(frame, (Rectangle){ x + GARDEN_FLOWER_X, y + GARDEN_PLOT_HEIGHT - frame.height, frame.width, frame.height }, texel);
+        if (!garden->isAlive[i]) continue;
+        const float healthHeight = GARDEN_BAR_HEIGHT * garden->health[i] / 100;
+        const float hidrationHeight = GARDEN_BAR_HEIGHT * garden->waterLevel[i] / FLOWER_MAX_WATER_LEVEL;
+        BatchQuad(pixel, (Rectangle){ x + 2, y + 2 + GARDEN_BAR_HEIGHT - healthHeight, 2, healthHeight }, texel);
+        BatchQuad(pixel, (Rectangle){ x + 6, y + 2 + GARDEN_BAR_HEIGHT - hidrationHeight, 2, hidrationHeight }, texel);
+    }
+    rlEnd();
+    rlSetTexture(0);
+
+    // One sun or cloud over the whole garden
+    if (game->isSunUp) {
+        DrawTextureRec(textures->atlas, AtlasFrame(SpriteSun, game->sun.currentFrame), (Vector2){0, 0}, WHITE);
+    } else {
+        DrawTextureRec(textures->atlas, AtlasFrame(SpriteCloud, game->cloud.currentFrame), (Vector2){0, 0}, WHITE);
+    }
+    for (int i = 0; i < game->shieldCount; i++) {
+        DrawCircleV(game->shields[i], SHIELD_RADIUS, LIGHTGRAY);
+    }
+}
+
+void DrawProfilerOverlay(int x, int y, int fontSize) {
+    ProfileStats phases[PROFILER_MAX_PHASES];
+    const int phaseCount = ProfilerPhaseStats(phases, PROFILER_MAX_PHASES);
+    const ProfileStats frame = ProfilerFrameStats();
+    const int lineHeight = fontSize + 2;
+    DrawRectangle(x, y, fontSize * 22, lineHeight * (phaseCount + 2) + 4, Fade(BLACK, 0.7f));
+
+    y += 2;
+    DrawText("ms            p50    p95    p99    max", x + 4, y, fontSize, LIGHTGRAY);
+    y += lineHeight;
+    DrawText(TextFormat("%-12s %6.2f %6.2f %6.2f %6.2f", "frame", frame.p50, frame.p95, frame.p99, frame.max), x + 4, y, fontSize, YELLOW);
+    for (int i = 0; i < phaseCount; i++) {
+        y += lineHeight;
+        DrawText(TextFormat("%-12.12s %6.2f %6.2f %6.2f %6.2f", phases[i].name, phases[i].p50, phases[i].p95, phases[i].p99, phases[i].max), x + 4, y, fontSize, WHITE);
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef PIXEL_BLOOM_RENDER_H
+#define PIXEL_BLOOM_RENDER_H
+
+// Draws a Game into the native 160x90 render target. Shared by the game and
+// the render benchmark.
+
+#include "raylib.h"
+#include "sim.h"
+#include "atlas.h"
+#include "particle_renderer.h"
+#include "ui.h"
+
+typedef struct GameTextures {
+    Texture2D atlas;    // every sprite, see atlas.h
+    Texture2D weather;  // field weather layer, uploaded every frame in field mode
+    Widget score;       // HUD score, rasterized again only when the number changes
+    int shownScore;
+} GameTextures;
+
+// Also makes the atlas the shapes texture, so rectangles and circles don't
+// switch textures either
+void LoadGameTextures(GameTextures *textures);
+void UnloadGameTextures(GameTextures *textures);
+// Frame and per-phase percentiles from the profiler, drawn at screen resolution
+void DrawProfilerOverlay(int x, int y, int fontSize);
+// particles may be NULL to draw every particle with DrawPixelV. lag is how many
+// seconds before the last tick the frame shows, particles are drawn back where
+// they were then; 0 draws the tick as it is. shields false leaves the shields
+// to the caller, e.g. drawn over the upscaled frame
+void DrawNativeFrame(RenderTexture2D target, const Game *game, GameTextures *textures, ParticleRenderer *particles, float lag, bool shields);
+// Garden mode, in garden coordinates: call inside BeginMode2D with a camera
+// that fits GardenWidth x GardenHeight on screen. Every flower and its bars go
+// through raylib's batch as quads of the atlas, so thousands of them are a
+// draw call or two. No HUD, the caller shows the score at screen resolution
+void DrawGardenFrame(const Game *game, const GameTextures *textures, ParticleRenderer *particles, float lag);
+
+#endif // PIXEL_BLOOM_RENDER_H
@@ -0,0 +1,475 @@
+#include "sim.h"
+#include "profiler.h"
+
+// PCG32 (pcg-random.org): small, fast, and the same sequence on every platform
+static uint32_t SimRandomNext(Game *game) {
+    const uint64_t state = game->rngState;
+    game->rngState = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    const uint32_t xorshifted = (uint32_t)(((state >> 18) ^ state) >> 27);
+    const uint32_t rotation = (uint32_t)(state >> 59);
+    return (xorshifted >> rotation) | (xorshifted << ((32 - rotation) & 31));
+}
+
+// Inclusive range, like raylib's GetRandomValue
+static int SimRandomValue(Game *game, int min, int max) {
+    if (min > max) {
+        const int tmp = max;
+        max = min;
+        min = tmp;
+    }
+    return min + (int)(SimRandomNext(game) % (uint32_t)(max - min + 1));
+}
+
+void SimSeed(Game *game, uint64_t seed) {
+    game->rngState = 0;
+    SimRandomNext(game);
+    game->rngState += seed;
+    SimRandomNext(game);
+}
+
+Tuning SimDefaultTuning(void) {
+    return (Tuning){
+        .flowerWaterDrainSpeed = FLOWER_WATER_DRAIN_SPEED,
+        .windParticlesCD = WIND_PARTICLES_CD,
+        .waterParticlesCD = WATER_PARTICLES_CD,
+        .dehidrationDamage = DEHIDRATION_DAMAGE,
+        .tooMuchWaterDamage = TOO_MUCH_WATER_DAMAGE,
+    };
+}
+
+bool SimInit(Game *game, int windCapacity, int waterCapacity) {
+    game->tuning = SimDefaultTuning();
+    if (!ParticleStoreInit(&game->wind, windCapacity) ||
+        !ParticleStoreInit(&game->water, waterCapacity) ||
+        !SpatialGridInit(&game->grid, windCapacity > waterCapacity ? windCapacity : waterCapacity, NATIVE_WIDTH, NATIVE_HEIGHT)) {
+        SimFree(game);
+        return false;
+    }
+    return true;
+}
+
+bool SimInitGarden(Game *game, int count) {
+    const int capacity = count * GARDEN_PARTICLES_PER_FLOWER;
+    if (!SimInit(game, capacity, capacity)) return false;
+    // Shields and particles are in garden coordinates, so the grid spans every plot
+    SpatialGridFree(&game->grid);
+    if (!GardenInit(&game->garden, count) ||
+        !SpatialGridInit(&game->grid, capacity, (float)game->garden.columns * GARDEN_PLOT_WIDTH, (float)game->garden.rows * GARDEN_PLOT_HEIGHT)) {
+        SimFree(game);
+        return false;
+    }
+    return true;
+}
+
+bool SimInitWeatherField(Game *game) {
+    if (!SimInit(game, DEFAULT_WIND_CAPACITY, DEFAULT_WATER_CAPACITY)) return false;
+    if (!WeatherFieldInit(&game->weather)) {
+        SimFree(game);
+        return false;
+    }
+    return true;
+}
+
+void SimFree(Game *game) {
+    WeatherFieldFree(&game->weather);
+    ParticleStoreFree(&game->wind);
+    ParticleStoreFree(&game->water);
+    SpatialGridFree(&game->grid);
+    GardenFree(&game->garden);
+}
+
+void SimReset(Game *game) {
+    game->flower.frameTimer = 0;
+    game->flower.waterLevel = 120;
+    game->flower.currentFrame = 0;
+    game->flower.health = 100;
+    game->flower.isAlive = true;
+    GardenReset(&game->garden);
+    game->cloud.frameTimer = 0;
+    game->cloud.currentFrame = 0;
+    game->sun.frameTimer = 0;
+    game->sun.currentFrame = 0;
+    game->wind.count = 0;
+    game->water.count = 0;
+    if (game->weather.wind != NULL) WeatherFieldClear(&game->weather);
+    game->windParticleCD = game->tuning.windParticlesCD;
+    game->waterParticleCD = game->tuning.waterParticlesCD;
+    game->isSunUp = true;
+    game->isShielding = false;
+    game->shieldCount = 0;
+    game->score = 0;
+    game->gameOverType = NoneDamage;
+    game->skipInput = false;
+    game->isPaused = false;
+}
+
+static void GameOver(Game *game, DamageType damageType) {
+    if(game->score > game->highestScore) {
+        game->highestScore = game->score;
+    }
+    game->state = StateGameOver;
+    game->gameOverType = damageType;
+}
+
+void TakeDamage(Game *game, float damage, DamageType damageType) {
+    if (!game->flower.isAlive) return;
+    game->flower.health =  game->flower.health - damage;
+    if (game->flower.health <= 0) {
+        game->flower.isAlive = false;
+        game->flower.health = 0;
+        GameOver(game, damageType);
+    }
+}
+
+// A garden session ends with its last flower
+static void GardenDeath(Game *game, DamageType damageType) {
+    if (game->garden.aliveCount == 0 && game->state == StateInGame) {
+        GameOver(game, damageType);
+    }
+}
+
+void TakeWater(Game *game, float water) {
+    if (!game->flower.isAlive) return;
+    game->flower.waterLevel += water;
+    if (game->flower.waterLevel > FLOWER_MAX_WATER_LEVEL) {
+        TakeDamage(game, game->tuning.tooMuchWaterDamage, DrawningDamage);
+        game->flower.waterLevel = FLOWER_MAX_WATER_LEVEL;
+    } else {
+        game->flower.health += 1;
+        if(game->flower.health > 100) {
+            game->flower.health = 100;
+        }
+    }
+}
+
+static void UpdateShield(Game *game, Input input) {
+    if (input.toggleWeather) {
+        game->isSunUp = !game->isSunUp;
+        game->cloud.currentFrame = 0;
+        game->sun.currentFrame = 0;
+        game->wind.count = 0;
+        game->water.count = 0;
+        if (game->weather.wind != NULL) WeatherFieldClear(&game->weather);
+        game->windParticleCD = game->tuning.windParticlesCD;
+        game->waterParticleCD = game->tuning.waterParticlesCD;
+        game->skipInput = true;
+    }
+    if(game->skipInput){
+        game->shieldPosition = (Vector2){0};
+        game->isShielding = false;
+    }else{
+        if (input.shieldPressed) {
+            game->isShielding = true;
+        }
+        if (input.shieldReleased) {
+            game->shieldPosition = (Vector2){0};
+            game->isShielding = false;
+        }
+    }
+    game->shieldCount = 0;
+    if(game->isShielding) {
+        game->shieldPosition = input.shieldPosition;
+        game->shields[game->shieldCount++] = game->shieldPosition;
+    }
+    if (!game->skipInput) {
+        for (int i = 0; i < input.extraShieldCount && game->shieldCount < MAX_SHIELDS; i++) {
+            game->shields[game->shieldCount++] = input.extraShields[i];
+        }
+    }
+    game->skipInput = false;
+}
+
+static void UpdateAnimations(Game *game, float delta) {
+    if (game->isSunUp) {
+        game->sun.frameTimer += delta;
+        if (game->sun.frameTimer >= SUN_FRAME_SPEED) {
+            game->sun.frameTimer = 0;
+            game->sun.currentFrame = SimRandomValue(game, 0, SUN_FRAMES - 1);
+            if (game->sun.currentFrame >= SUN_FRAMES) game->sun.currentFrame = 0;
+        }
+    } else {
+        game->cloud.frameTimer += delta;
+        if (game->cloud.frameTimer >= CLOUD_FRAME_SPEED) {
+            game->cloud.frameTimer = 0;
+            game->cloud.currentFrame += 1;
+            if (game->cloud.currentFrame >= CLOUD_FRAMES) game->cloud.currentFrame = 0;
+        }
+    }
+}
+
+static void UpdateFlower(Game *game, float delta) {
+    if(!game->flower.isAlive) return;
+    game->flower.frameTimer += delta;
+    if (game->flower.frameTimer >= FLOWER_FRAME_SPEED) {
+        game->flower.frameTimer = 0;
+        game->flower.currentFrame += 1;
+        if (game->flower.currentFrame >= FLOWER_FRAMES) game->flower.currentFrame = 0;
+    }
+    if (game->flower.waterLevel != 0.0) {
+        if(game->isSunUp){
+            game->flower.waterLevel = game->flower.waterLevel - (game->tuning.flowerWaterDrainSpeed * delta);
+        }
+    }else{
+        TakeDamage(game, game->tuning.dehidrationDamage * delta, DehidrationDamage);
+    }
+    if (game->flower.waterLevel < 0.0) {
+        game->flower.waterLevel = 0.0;
+        TakeDamage(game, game->tuning.dehidrationDamage * delta, DehidrationDamage);
+    }
+}
+
+// Particles per job chunk. Below that a tick is too short to be worth waking
+// the workers for
+#define PARTICLE_JOB_GRAIN 16384
+
+typedef struct ParticleJob {
+    ParticleStore *store;
+    float *lane;            // integrated and tested against limit
+    float scale;
+    float limit;
+    float tile;             // garden plot size along the lane, 0 outside garden mode
+    bool shielding;         // single shield, tested in the classify pass
+    Vector2 shield;
+    ParticleHitCount hits[JOB_MAX_CHUNKS];
+    int offsets[JOB_MAX_CHUNKS]; // survivors per chunk, then where each one compacts to
+} ParticleJob;
+
+static void IntegrateAndClassifyJob(void *data, int chunk, int begin, int end) {
+    PROFILE_BEGIN(zone, "particle chunk");
+    ParticleJob *job = data;
+    ParticlesIntegrate(job->lane, job->store->value, job->scale, begin, end);
+    if (job->tile > 0) {
+        job->hits[chunk] = ParticlesClassifyTiled(job->store, job->lane, job->tile, job->limit,
+            job->shielding, job->shield.x, job->shield.y, SHIELD_RADIUS, begin, end);
+    } else {
+        job->hits[chunk] = ParticlesClassify(job->store, job->lane, job->limit,
+            job->shielding, job->shield.x, job->shield.y, SHIELD_RADIUS, begin, end);
+    }
+    PROFILE_END(zone);
+}
+
+static void CountSurvivorsJob(void *data, int chunk, int begin, int end) {
+    ParticleJob *job = data;
+    job->offsets[chunk] = ParticlesCountSurvivors(job->store, begin, end);
+}
+
+static void CompactJob(void *data, int chunk, int begin, int end) {
+    ParticleJob *job = data;
+    ParticlesCompactRange(job->store, begin, end, job->offsets[chunk]);
+}
+
+// Moves, then runs the ground and shield tests on one store. A single shield
+// is cheapest as part of the vectorized classify pass; several go through the
+// grid so the cost follows the particles near a shield instead of particles
+// times shields. Chunk counts are summed in chunk order, so the result is the
+// same for any number of threads.
+static ParticleHitCount MoveAndCollideParticles(Game *game, ParticleJob *job) {
+    const bool linear = game->shieldCount <= 1;
+    job->shielding = linear && game->shieldCount == 1;
+    job->shield = game->shieldCount > 0 ? game->shields[0] : (Vector2){0};
+    const int chunks = JobsParallelFor(game->jobs, job->store->count, PARTICLE_JOB_GRAIN, IntegrateAndClassifyJob, job);
+    ParticleHitCount hits = {0};
+    for (int chunk = 0; chunk < chunks; chunk++) {
+        hits.ground += job->hits[chunk].ground;
+        hits.shield += job->hits[chunk].shield;
+    }
+    if (!linear) {
+        PROFILE_BEGIN(grid, "shield grid");
+        SpatialGridUpdate(&game->grid, job->store);
+        for (int i = 0; i < game->shieldCount; i++) {
+            hits.shield += SpatialGridMarkCircle(&game->grid, job->store, game->shields[i].x, game->shields[i].y, SHIELD_RADIUS);
+        }
+        PROFILE_END(grid);
+    }
+    return hits;
+}
+
+// In place on one thread; with more, every chunk copies its survivors to the
+// spare lanes at the offset the chunks before it add up to
+static void CompactParticles(Game *game, ParticleJob *job) {
+    ParticleStore *store = job->store;
+    if (JobsThreadCount(game->jobs) == 1 || JobsChunkCount(store->count, PARTICLE_JOB_GRAIN) <= 1) {
+        ParticlesCompact(store);
+        return;
+    }
+    const int chunks = JobsParallelFor(game->jobs, store->count, PARTICLE_JOB_GRAIN, CountSurvivorsJob, job);
+    int total = 0;
+    for (int chunk = 0; chunk < chunks; chunk++) {
+        const int survivors = job->offsets[chunk];
+        job->offsets[chunk] = total;
+        total += survivors;
+    }
+    JobsParallelFor(game->jobs, store->count, PARTICLE_JOB_GRAIN, CompactJob, job);
+    ParticlesSwapSpare(store, total);
+}
+
+void UpdateWindParticles(Game *game, float delta) {
+    PROFILE_BEGIN(zone, "wind particles");
+    ParticleStore *wind = &game->wind;
+    game->windParticleCD -= delta;
+    // Not zero-initialized: the per-chunk arrays are written before they're read
+    Garden *garden = &game->garden;
+    ParticleJob job;
+    job.store = wind;
+    job.lane = wind->x;
+    job.scale = delta;
+    job.limit = garden->count > 0 ? GARDEN_FLOWER_LINE : FLOWER_LINE;
+    job.tile = garden->count > 0 ? GARDEN_PLOT_WIDTH : 0;
+    const ParticleHitCount hits = MoveAndCollideParticles(game, &job);
+    if (hits.ground > 0) {
+        for (int i = 0; i < wind->count; i++) {
+            if (wind->hits[i] != ParticleHitGround) continue;
+            if (garden->count == 0) {
+                TakeDamage(game, wind->value[i], WindDamage);
+            } else if (GardenDamage(garden, GardenFlowerAt(garden, wind->x[i], wind->y[i]), wind->value[i])) {
+                GardenDeath(game, WindDamage);
+            }
+        }
+    }
+    if (hits.ground + hits.shield > 0) {
+        CompactParticles(game, &job);
+    }
+    if (game->windParticleCD < 0) {
+        game->windParticleCD = game->tuning.windParticlesCD;
+        if (garden->count == 0) {
+            const float power = 10 + SimRandomValue(game, 1, 10);
+            const float y = NATIVE_HEIGHT - 30 + SimRandomValue(game, 1, 20);
+            ParticleStorePush(wind, 1, y, power);
+        }
+        // Every living flower gets its own gust from the left of its plot
+        for (int f = 0; f < garden->count; f++) {
+            if (!garden->isAlive[f]) continue;
+            const float power = 10 + SimRandomValue(game, 1, 10);
+            const float x = (f % garden->columns) * GARDEN_PLOT_WIDTH + 1;
+            const float y = (f / garden->columns) * GARDEN_PLOT_HEIGHT + NATIVE_HEIGHT - 30 + SimRandomValue(game, 1, 20);
+            if (!ParticleStorePush(wind, x, y, power)) break;
+        }
+    }
+    PROFILE_END(zone);
+}
+
+void UpdateWaterParticles(Game *game, float delta) {
+    PROFILE_BEGIN(zone, "water particles");
+    ParticleStore *water = &game->water;
+    Garden *garden = &game->garden;
+    ParticleJob job;
+    job.store = water;
+    job.lane = water->y;
+    job.scale = WATER_FALL_SPEED * delta;
+    job.limit = garden->count > 0 ? GARDEN_GROUND_LEVEL : GROUND_LEVEL;
+    job.tile = garden->count > 0 ? GARDEN_PLOT_HEIGHT : 0;
+    const ParticleHitCount hits = MoveAndCollideParticles(game, &job);
+    if (hits.ground > 0) {
+        for (int i = 0; i < water->count; i++) {
+            if (water->hits[i] != ParticleHitGround) continue;
+            if (garden->count == 0) {
+                TakeWater(game, water->value[i]);
+            } else if (GardenWater(garden, GardenFlowerAt(garden, water->x[i], water->y[i]), water->value[i], game->tuning.tooMuchWaterDamage)) {
+                GardenDeath(game, DrawningDamage);
+            }
+        }
+    }
+    if (hits.ground + hits.shield > 0) {
+        CompactParticles(game, &job);
+    }
+    game->waterParticleCD -= delta;
+    if (game->waterParticleCD < 0) {
+        game->waterParticleCD = game->tuning.waterParticlesCD;
+        if (garden->count == 0) {
+            const float amount = SimRandomValue(game, 1, 10);
+            const float x = 60 + SimRandomValue(game, 1, 20);
+            // A full store recycles its newest drop, like the fixed array did
+            if (water->count == water->capacity) {
+                water->count -= 1;
+            }
+            ParticleStorePush(water, x, 0, amount);
+        }
+        // A drop over every living flower, from the top of its plot
+        for (int f = 0; f < garden->count; f++) {
+            if (!garden->isAlive[f]) continue;
+            const float amount = SimRandomValue(game, 1, 10);
+            const float x = (f % garden->columns) * GARDEN_PLOT_WIDTH + GARDEN_FLOWER_X + SimRandomValue(game, 1, 20);
+            const float y = (f / garden->columns) * GARDEN_PLOT_HEIGHT;
+            if (!ParticleStorePush(water, x, y, amount)) break;
+        }
+    }
+    PROFILE_END(zone);
+}
+
+// Same cooldowns and random draws as the particles, a gust or a drop now
+// stamps a few cells of the field instead of pushing a particle
+void UpdateWeatherField(Game *game, float delta) {
+    PROFILE_BEGIN(zone, "weather field");
+    WeatherField *weather = &game->weather;
+    WeatherFieldClearObstacles(weather);
+    for (int i = 0; i < game->shieldCount; i++) {
+        WeatherFieldAddObstacle(weather, game->shields[i].x, game->shields[i].y, SHIELD_RADIUS);
+    }
+    if (game->isSunUp) {
+        // Past the flower line, in the band the gusts blow through
+        const WeatherRect flower = { FLOWER_LINE + 1, NATIVE_HEIGHT - 30, 1, 30 };
+        const float caught = WeatherFieldStepWind(weather, delta, flower);
+        if (caught > 0) {
+            TakeDamage(game, caught / (WEATHER_GUST_ROWS * WEATHER_GUST_COLUMNS), WindDamage);
+        }
+        game->windParticleCD -= delta;
+        if (game->windParticleCD < 0) {
+            game->windParticleCD = game->tuning.windParticlesCD;
+            const float power = 10 + SimRandomValue(game, 1, 10);
+            const int y = NATIVE_HEIGHT - 30 + SimRandomValue(game, 1, 20);
+            const WeatherRect gust = { 0, y - WEATHER_GUST_ROWS / 2, WEATHER_GUST_COLUMNS, WEATHER_GUST_ROWS };
+            WeatherFieldAddWind(weather, gust, power);
+        }
+    } else {
+        // Just below the ground line, under where the drops fall
+        const WeatherRect flower = { 60, GROUND_LEVEL + 1, 22, 1 };
+        weather->caughtWater += WeatherFieldStepRain(weather, delta, flower);
+        while (weather->caughtWater >= WEATHER_DROP_AMOUNT) {
+            weather->caughtWater -= WEATHER_DROP_AMOUNT;
+            TakeWater(game, WEATHER_DROP_AMOUNT);
+        }
+        game->waterParticleCD -= delta;
+        if (game->waterParticleCD < 0) {
+            game->waterParticleCD = game->tuning.waterParticlesCD;
+            const float amount = SimRandomValue(game, 1, 10);
+            const int x = 60 + SimRandomValue(game, 1, 20);
+            const WeatherRect drop = { x, 0, WEATHER_DROP_COLUMNS, 1 };
+            WeatherFieldAddRain(weather, drop, amount / WEATHER_DROP_COLUMNS);
+        }
+    }
+    PROFILE_END(zone);
+}
+
+void SimStep(Game *game, Input input, float delta) {
+    if (game->state != StateInGame || game->isPaused) return;
+
+    UpdateShield(game, input);
+
+    if (game->garden.count > 0) {
+        // Scores like one flower with the garden's mean health
+        if (game->isSunUp) {
+            game->score += game->garden.meanHealth/100 * delta;
+        }
+        UpdateAnimations(game, delta);
+        PROFILE_BEGIN(zone, "garden");
+        if (GardenGrow(&game->garden, game->isSunUp, game->tuning.flowerWaterDrainSpeed, game->tuning.dehidrationDamage, delta) > 0) {
+            GardenDeath(game, DehidrationDamage);
+        }
+        PROFILE_END(zone);
+    } else {
+        // Calc Score
+        if(game->flower.isAlive && game->isSunUp) {
+            game->score += game->flower.health/100 * delta;
+        }
+        UpdateAnimations(game, delta);
+        UpdateFlower(game, delta);
+    }
+
+    if (game->weather.wind != NULL) {
+        UpdateWeatherField(game, delta);
+    } else if (game->isSunUp) {
+        UpdateWindParticles(game, delta);
+    } else {
+        UpdateWaterParticles(game, delta);
+    }
+}
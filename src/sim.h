@@ -0,0 +1,181 @@
+#ifndef PIXEL_BLOOM_SIM_H
+#define PIXEL_BLOOM_SIM_H
+
+// Game simulation core: everything the tick needs and nothing that needs a
+// window, a GL context or an audio device. Shared by the game and the
+// headless runner.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "garden.h"
+#include "jobs.h"
+#include "particles.h"
+#include "spatial_grid.h"
+#include "weather.h"
+
+#if !defined(RL_VECTOR2_TYPE)
+// Same layout as raylib's Vector2, so raylib.h can be included before or after
+typedef struct Vector2 {
+    float x;
+    float y;
+} Vector2;
+#define RL_VECTOR2_TYPE
+#endif
+
+// Particle capacities of the regular game, SimInit takes any other
+#define DEFAULT_WIND_CAPACITY 200
+#define DEFAULT_WATER_CAPACITY 200
+
+#define NATIVE_WIDTH 160 // e.g., 160x90 for a 16:9 aspect ratio
+#define NATIVE_HEIGHT 90
+
+static const float PHYSICS_TIME            = 0.02; // default fixed tick, 50Hz
+static const int DEHIDRATION_DAMAGE = 10;
+static const int TOO_MUCH_WATER_DAMAGE = 10;
+static const int SHIELD_RADIUS = 5;
+#define MAX_SHIELDS 8 // the mouse plus extra touch points or co-op cursors
+static const int GROUND_LEVEL = NATIVE_WIDTH - 85;   // water reaches the flower below this y
+static const int FLOWER_LINE = NATIVE_WIDTH - 85;    // wind reaches the flower past this x
+// Wind moves power px/s right, water falls amount * WATER_FALL_SPEED px/s
+static const float WATER_FALL_SPEED = 10;
+
+// Field weather (weather.h). A gust or a drop fills a few cells, and the wind
+// that reaches the flower hurts per gust's worth of cells, so a gust does
+// about the damage of a wind particle of the same power
+#define WEATHER_GUST_ROWS 3
+#define WEATHER_GUST_COLUMNS 2
+#define WEATHER_DROP_COLUMNS 2
+// The flower drinks the rain it catches a mean drop at a time
+static const float WEATHER_DROP_AMOUNT = 5.5f;
+
+// Flower consts
+#define FLOWER_FRAMES 7   // like SUN_ and CLOUD_FRAMES, must match the atlas sheets (src/sprite_sheet.c)
+static const float FLOWER_FRAME_SPEED  = .3;
+static const float FLOWER_WATER_DRAIN_SPEED = 10;
+static const float FLOWER_MAX_WATER_LEVEL = 200;
+
+// Sun consts
+#define SUN_FRAMES 8
+static const float SUN_FRAME_SPEED  = .3;
+static const float SUN_AMOUNT = 10.0;
+// Half of the old 1s: the render pass used to tick the cooldown a second time
+static const float WIND_PARTICLES_CD = .5;
+
+// Cloud consts
+#define CLOUD_FRAMES 8
+static const float CLOUD_FRAME_SPEED  = .3;
+static const float CLOUD_AMOUNT = 5.0;
+// Half of the old .3s: the render pass used to spawn a second drop per cooldown
+static const float WATER_PARTICLES_CD = .15;
+
+// Balance constants a Game plays with. SimInit starts from the defaults above,
+// the balance runner sweeps them
+typedef struct Tuning {
+    float flowerWaterDrainSpeed;    // FLOWER_WATER_DRAIN_SPEED
+    float windParticlesCD;          // WIND_PARTICLES_CD
+    float waterParticlesCD;         // WATER_PARTICLES_CD
+    float dehidrationDamage;        // DEHIDRATION_DAMAGE
+    float tooMuchWaterDamage;       // TOO_MUCH_WATER_DAMAGE
+} Tuning;
+
+typedef struct Flower {
+    float frameTimer;
+    float waterLevel;
+    float health;
+    int currentFrame;
+    bool isAlive;
+} Flower;
+
+typedef struct Sun {
+    float frameTimer;
+    int currentFrame;
+    int sunAmount;
+} Sun;
+
+typedef struct Cloud {
+    float frameTimer;
+    int currentFrame;
+    int rainAmount;
+} Cloud;
+
+typedef enum GameStateType {
+    StateInGame = 1,
+    StateStartMenu = 2,
+    StateGameOver = 3,
+} GameStateType;
+
+typedef enum DamageType {
+    NoneDamage = 0,
+    DehidrationDamage = 1,
+    WindDamage = 2,
+    DrawningDamage = 3,
+} DamageType;
+
+// Player intent for one tick, already in native (160x90) coordinates
+typedef struct Input {
+    Vector2 shieldPosition;
+    bool toggleWeather;  // space or a click on the flower
+    bool shieldPressed;
+    bool shieldReleased;
+    // Shields held this tick on top of the mouse one (touches, co-op cursors)
+    Vector2 extraShields[MAX_SHIELDS - 1];
+    int extraShieldCount;
+} Input;
+
+typedef struct Game {
+    ParticleStore wind;   // value lane is the wind power
+    ParticleStore water;  // value lane is the water amount
+    Flower flower;
+    Garden garden;        // garden mode when it has flowers, the flower sits unused then
+    WeatherField weather; // field weather when allocated, the particle stores sit unused then
+    Sun sun;
+    Cloud cloud;
+    SpatialGrid grid;     // shield broad phase, rebuilt for each store it's used on
+    JobSystem *jobs;      // not owned, NULL runs every pass on the calling thread
+    uint64_t rngState;    // every random draw of the sim, see SimSeed
+    Tuning tuning;
+    Vector2 shieldPosition;
+    Vector2 shields[MAX_SHIELDS]; // every shield active this tick, mouse first
+    int shieldCount;
+	GameStateType state;
+    DamageType gameOverType;
+    int width;
+    int height;
+    float virtualRatio;
+    float score;
+    float highestScore;
+    float windParticleCD;
+    float waterParticleCD;
+    bool isSunUp;
+    bool skipInput;
+    bool isMusicPaused;
+    bool isPaused;
+    bool isShielding;
+} Game;
+
+Tuning SimDefaultTuning(void);
+// Allocates the particle stores and sets the default tuning, returns false when out of memory
+bool SimInit(Game *game, int windCapacity, int waterCapacity);
+// Garden mode: allocates count flowers and particle stores sized for them
+bool SimInitGarden(Game *game, int count);
+// Field weather: wind and rain on a grid instead of particles, for the single
+// flower only. Returns false when out of memory
+bool SimInitWeatherField(Game *game);
+void SimFree(Game *game);
+// Seeds the sim's random numbers. SimReset leaves them alone, so back to back
+// sessions differ; replaying one means seeding with the state it started at
+void SimSeed(Game *game, uint64_t seed);
+// Puts a session back to its starting state, keeping highestScore
+void SimReset(Game *game);
+// Advances an in-game, unpaused session by delta seconds
+void SimStep(Game *game, Input input, float delta);
+void TakeDamage(Game *game, float damage, DamageType damageType);
+void TakeWater(Game *game, float water);
+// Particle passes of SimStep, exposed for the benchmarks
+void UpdateWindParticles(Game *game, float delta);
+void UpdateWaterParticles(Game *game, float delta);
+// SimStep's weather in field mode, instead of the two above
+void UpdateWeatherField(Game *game, float delta);
+
+#endif // PIXEL_BLOOM_SIM_H
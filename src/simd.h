@@ -0,0 +1,99 @@
+#ifndef PIXEL_BLOOM_SIMD_H
+#define PIXEL_BLOOM_SIMD_H
+
+// Minimal float vector layer for the sim kernels. Picks the widest instruction
+// set the compiler was told it may use: AVX2 (8 lanes), SSE2, NEON or WASM
+// SIMD (4 lanes), and falls back to plain scalar code (1 lane).
+// Only mul/add/compare/truncate are used, no FMA, so every path rounds
+// exactly like the scalar tail loops.
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define SIMD_AVX2 1
+    #define SIMD_WIDTH 8
+    typedef __m256 SimdFloat;
+    #define SimdLoad(p)              _mm256_loadu_ps(p)
+    #define SimdStore(p, v)          _mm256_storeu_ps((p), (v))
+    #define SimdSet1(s)              _mm256_set1_ps(s)
+    #define SimdAdd(a, b)            _mm256_add_ps((a), (b))
+    #define SimdSub(a, b)            _mm256_sub_ps((a), (b))
+    #define SimdMul(a, b)            _mm256_mul_ps((a), (b))
+    #define SimdMin(a, b)            _mm256_min_ps((a), (b))
+    #define SimdMax(a, b)            _mm256_max_ps((a), (b))
+    #define SimdGreater(a, b)        _mm256_cmp_ps((a), (b), _CMP_GT_OQ)
+    #define SimdLessEqual(a, b)      _mm256_cmp_ps((a), (b), _CMP_LE_OQ)
+    #define SimdAnd(a, b)            _mm256_and_ps((a), (b))
+    #define SimdOr(a, b)             _mm256_or_ps((a), (b))
+    #define SimdAndNot(a, b)         _mm256_andnot_ps((b), (a))   // a & ~b
+    #define SimdMaskBits(m)          _mm256_movemask_ps(m)
+    #define SimdTruncate(a)          _mm256_round_ps((a), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC)
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SIMD_SSE2 1
+    #define SIMD_WIDTH 4
+    typedef __m128 SimdFloat;
+    #define SimdLoad(p)              _mm_loadu_ps(p)
+    #define SimdStore(p, v)          _mm_storeu_ps((p), (v))
+    #define SimdSet1(s)              _mm_set1_ps(s)
+    #define SimdAdd(a, b)            _mm_add_ps((a), (b))
+    #define SimdSub(a, b)            _mm_sub_ps((a), (b))
+    #define SimdMul(a, b)            _mm_mul_ps((a), (b))
+    #define SimdMin(a, b)            _mm_min_ps((a), (b))
+    #define SimdMax(a, b)            _mm_max_ps((a), (b))
+    #define SimdGreater(a, b)        _mm_cmpgt_ps((a), (b))
+    #define SimdLessEqual(a, b)      _mm_cmple_ps((a), (b))
+    #define SimdAnd(a, b)            _mm_and_ps((a), (b))
+    #define SimdOr(a, b)             _mm_or_ps((a), (b))
+    #define SimdAndNot(a, b)         _mm_andnot_ps((b), (a))      // a & ~b
+    #define SimdMaskBits(m)          _mm_movemask_ps(m)
+    #define SimdTruncate(a)          _mm_cvtepi32_ps(_mm_cvttps_epi32(a))   // |a| < 2^31
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define SIMD_NEON 1
+    #define SIMD_WIDTH 4
+    typedef float32x4_t SimdFloat;
+    #define SimdLoad(p)              vld1q_f32(p)
+    #define SimdStore(p, v)          vst1q_f32((p), (v))
+    #define SimdSet1(s)              vdupq_n_f32(s)
+    #define SimdAdd(a, b)            vaddq_f32((a), (b))
+    #define SimdSub(a, b)            vsubq_f32((a), (b))
+    #define SimdMul(a, b)            vmulq_f32((a), (b))
+    #define SimdMin(a, b)            vminq_f32((a), (b))
+    #define SimdMax(a, b)            vmaxq_f32((a), (b))
+    #define SimdGreater(a, b)        vreinterpretq_f32_u32(vcgtq_f32((a), (b)))
+    #define SimdLessEqual(a, b)      vreinterpretq_f32_u32(vcleq_f32((a), (b)))
+    #define SimdAnd(a, b)            vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)))
+    #define SimdOr(a, b)             vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)))
+    #define SimdAndNot(a, b)         vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)))
+    #define SimdTruncate(a)          vcvtq_f32_s32(vcvtq_s32_f32(a))     // |a| < 2^31
+    static inline int SimdMaskBits(SimdFloat mask) {
+        const uint32x4_t bits = vshrq_n_u32(vreinterpretq_u32_f32(mask), 31);
+        return (int)(vgetq_lane_u32(bits, 0) | (vgetq_lane_u32(bits, 1) << 1) |
+                     (vgetq_lane_u32(bits, 2) << 2) | (vgetq_lane_u32(bits, 3) << 3));
+    }
+#elif defined(__wasm_simd128__)
+    #include <wasm_simd128.h>
+    #define SIMD_WASM 1
+    #define SIMD_WIDTH 4
+    typedef v128_t SimdFloat;
+    #define SimdLoad(p)              wasm_v128_load(p)
+    #define SimdStore(p, v)          wasm_v128_store((p), (v))
+    #define SimdSet1(s)              wasm_f32x4_splat(s)
+    #define SimdAdd(a, b)            wasm_f32x4_add((a), (b))
+    #define SimdSub(a, b)            wasm_f32x4_sub((a), (b))
+    #define SimdMul(a, b)            wasm_f32x4_mul((a), (b))
+    #define SimdMin(a, b)            wasm_f32x4_pmin((a), (b))
+    #define SimdMax(a, b)            wasm_f32x4_pmax((a), (b))
+    #define SimdGreater(a, b)        wasm_f32x4_gt((a), (b))
+    #define SimdLessEqual(a, b)      wasm_f32x4_le((a), (b))
+    #define SimdAnd(a, b)            wasm_v128_and((a), (b))
+    #define SimdOr(a, b)             wasm_v128_or((a), (b))
+    #define SimdAndNot(a, b)         wasm_v128_andnot((a), (b))   // a & ~b
+    #define SimdMaskBits(m)          ((int)wasm_i32x4_bitmask(m))
+    #define SimdTruncate(a)          wasm_f32x4_trunc(a)
+#else
+    #define SIMD_SCALAR 1
+    #define SIMD_WIDTH 1
+#endif
+
+#endif // PIXEL_BLOOM_SIMD_H
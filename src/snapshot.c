@@ -0,0 +1,468 @@
+#include "snapshot.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Zero runs shorter than this stay in the literal run around them, a new pair
+// of runs costs about as much
+#define RLE_MIN_ZEROS 8
+
+typedef struct SnapshotEntry {
+    long long tick;
+    int offset;         // into bytes
+    int size;           // encoded
+    int rawSize;        // decoded
+    bool keyframe;
+} SnapshotEntry;
+
+struct SnapshotRing {
+    uint8_t *bytes;     // encoded snapshots, allocated first to last and wrapping around
+    int budget;
+    int head;           // where the next one goes
+    SnapshotEntry *entries;
+    int entryCapacity;
+    int first;          // oldest entry
+    int count;
+    int keyframeInterval;
+    long long nextTick;
+    long long keyTick;  // tick of the keyframe in key
+    bool needKey;       // key no longer matches a stored keyframe
+    uint8_t *key;       // the last keyframe, unencoded, what deltas XOR against
+    int keySize;
+    uint8_t *image;     // scratch: a snapshot, unencoded
+    uint8_t *encoded;   // scratch: a snapshot, encoded
+    size_t scratchCapacity;
+};
+
+// Snapshot layout, see snapshot.h
+
+static size_t ImageSize(const Game *game) {
+    size_t size = sizeof(Game);
+    size += sizeof(float) * 3 * ((size_t)game->wind.count + (size_t)game->water.count);
+    size += (size_t)game->garden.count * (sizeof(float) * 3 + 2);
+    if (game->weather.wind != NULL) size += sizeof(float) * 2 * WEATHER_CELLS;
+    return size;
+}
+
+static uint8_t *Put(uint8_t *out, const void *data, size_t size) {
+    if (size > 0) memcpy(out, data, size);
+    return out + size;
+}
+
+static const uint8_t *Get(const uint8_t *in, void *data, size_t size) {
+    if (size > 0) memcpy(data, in, size);
+    return in + size;
+}
+
+static void WriteImage(uint8_t *out, const Game *game) {
+    // Without the pointers, which would only change the bytes between builds
+    // and runs, and the shield grid, which the next tick rebuilds
+    Game copy = *game;
+    copy.wind = (ParticleStore){ .count = game->wind.count, .capacity = game->wind.capacity };
+    copy.water = (ParticleStore){ .count = game->water.count, .capacity = game->water.capacity };
+    copy.garden.waterLevel = NULL;
+    copy.garden.health = NULL;
+    copy.garden.frameTimer = NULL;
+    copy.garden.currentFrame = NULL;
+    copy.garden.isAlive = NULL;
+    copy.grid = (SpatialGrid){0};
+    copy.jobs = NULL;
+    copy.weather = (WeatherField){ .caughtWater = game->weather.caughtWater };
+    out = Put(out, &copy, sizeof(copy));
+    const ParticleStore *stores[2] = { &game->wind, &game->water };
+    for (int s = 0; s < 2; s++) {
+        const size_t lane = sizeof(float) * stores[s]->count;
+        out = Put(out, stores[s]->x, lane);
+        out = Put(out, stores[s]->y, lane);
+        out = Put(out, stores[s]->value, lane);
+    }
+    const Garden *garden = &game->garden;
+    out = Put(out, garden->waterLevel, sizeof(float) * garden->count);
+    out = Put(out, garden->health, sizeof(float) * garden->count);
+    out = Put(out, garden->frameTimer, sizeof(float) * garden->count);
+    out = Put(out, garden->currentFrame, garden->count);
+    out = Put(out, garden->isAlive, garden->count);
+    if (game->weather.wind != NULL) {
+        out = Put(out, game->weather.wind, sizeof(float) * WEATHER_CELLS);
+        Put(out, game->weather.rain, sizeof(float) * WEATHER_CELLS);
+    }
+}
+
+static bool ReadImage(const uint8_t *in, size_t size, Game *game) {
+    if (size < sizeof(Game)) return false;
+    Game snapshot;
+    in = Get(in, &snapshot, sizeof(snapshot));
+    if (snapshot.wind.count < 0 || snapshot.wind.count > game->wind.capacity ||
+        snapshot.water.count < 0 || snapshot.water.count > game->water.capacity ||
+        snapshot.garden.count != game->garden.count) {
+        return false;
+    }
+    Game live = *game;
+    live.wind.count = snapshot.wind.count;
+    live.water.count = snapshot.water.count;
+    if (ImageSize(&live) != size) return false;
+
+    ParticleStore *stores[2] = { &game->wind, &game->water };
+    const int counts[2] = { snapshot.wind.count, snapshot.water.count };
+    for (int s = 0; s < 2; s++) {
+        const size_t lane = sizeof(float) * counts[s];
+        in = Get(in, stores[s]->x, lane);
+        in = Get(in, stores[s]->y, lane);
+        in = Get(in, stores[s]->value, lane);
+    }
+    Garden *garden = &game->garden;
+    in = Get(in, garden->waterLevel, sizeof(float) * garden->count);
+    in = Get(in, garden->health, sizeof(float) * garden->count);
+    in = Get(in, garden->frameTimer, sizeof(float) * garden->count);
+    in = Get(in, garden->currentFrame, garden->count);
+    in = Get(in, garden->isAlive, garden->count);
+    if (game->weather.wind != NULL) {
+        in = Get(in, game->weather.wind, sizeof(float) * WEATHER_CELLS);
+        Get(in, game->weather.rain, sizeof(float) * WEATHER_CELLS);
+    }
+
+    // The rest from the snapshot, around the live game's allocations
+    *game = snapshot;
+    game->wind = live.wind;
+    game->water = live.water;
+    game->garden = live.garden;
+    game->garden.aliveCount = snapshot.garden.aliveCount;
+    game->garden.meanHealth = snapshot.garden.meanHealth;
+    game->garden.meanWaterLevel = snapshot.garden.meanWaterLevel;
+    game->grid = live.grid;
+    game->weather = live.weather;
+    game->weather.caughtWater = snapshot.weather.caughtWater;
+    game->jobs = live.jobs;
+    // The window and the audio device don't rewind
+    game->width = live.width;
+    game->height = live.height;
+    game->virtualRatio = live.virtualRatio;
+    game->isMusicPaused = live.isMusicPaused;
+    return true;
+}
+
+// Run lengths as unsigned LEB128
+static uint8_t *PutLength(uint8_t *out, size_t value) {
+    while (value >= 0x80) {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+static const uint8_t *GetLength(const uint8_t *in, const uint8_t *end, size_t *value) {
+    *value = 0;
+    for (int shift = 0; in < end && shift < 64; shift += 7) {
+        const uint8_t byte = *in++;
+        *value |= (size_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return in;
+    }
+    return NULL;
+}
+
+// Byte i of image XOR base, base being 0 past its end
+static uint8_t XorAt(const uint8_t *image, const uint8_t *base, size_t baseSize, size_t i) {
+    return image[i] ^ (i < baseSize ? base[i] : 0);
+}
+
+// image XOR base as pairs of runs: zeros, then literal bytes. base may be
+// NULL for a keyframe. See ScratchFor for the worst case
+static size_t Encode(uint8_t *out, const uint8_t *image, size_t size, const uint8_t *base, size_t baseSize) {
+    uint8_t *start = out;
+    const size_t common = base == NULL ? 0 : (size < baseSize ? size : baseSize);
+    size_t i = 0;
+    while (i < size) {
+        size_t zeros = i;
+        // A word at a time over the unchanged stretches
+        while (zeros + 8 <= common && memcmp(image + zeros, base + zeros, 8) == 0) zeros += 8;
+        while (zeros < size && XorAt(image, base, baseSize, zeros) == 0) zeros++;
+        size_t end = zeros;
+        int run = 0;
+        while (end < size) {
+            if (XorAt(image, base, baseSize, end) == 0) {
+                if (++run == RLE_MIN_ZEROS) break;
+            } else {
+                run = 0;
+            }
+            end++;
+        }
+        // Ended on a zero run long enough to be worth a pair of its own
+        if (end < size) end -= RLE_MIN_ZEROS - 1;
+        out = PutLength(out, zeros - i);
+        out = PutLength(out, end - zeros);
+        for (size_t k = zeros; k < end; k++) {
+            *out++ = XorAt(image, base, baseSize, k);
+        }
+        i = end;
+    }
+    return (size_t)(out - start);
+}
+
+// XORs the runs into image, which holds the base already. Returns false when
+// they're corrupt or run past size
+static bool Decode(uint8_t *image, size_t size, const uint8_t *in, size_t encodedSize) {
+    const uint8_t *end = in + encodedSize;
+    size_t i = 0;
+    while (in < end) {
+        size_t zeros;
+        size_t literal;
+        in = GetLength(in, end, &zeros);
+        if (in == NULL) return false;
+        in = GetLength(in, end, &literal);
+        if (in == NULL || zeros > size - i || literal > size - i - zeros || literal > (size_t)(end - in)) return false;
+        i += zeros;
+        for (size_t k = 0; k < literal; k++) {
+            image[i++] ^= *in++;
+        }
+    }
+    return true;
+}
+
+// Encoding adds at most two length bytes per literal run, and literal runs
+// are at least RLE_MIN_ZEROS bytes apart
+static size_t ScratchFor(size_t size) {
+    return size + 2 * (size / RLE_MIN_ZEROS + 1) + 16;
+}
+
+static bool Reserve(SnapshotRing *ring, size_t size) {
+    const size_t needed = ScratchFor(size);
+    if (needed <= ring->scratchCapacity) return true;
+    uint8_t *key = realloc(ring->key, needed);
+    if (key != NULL) ring->key = key;
+    uint8_t *image = realloc(ring->image, needed);
+    if (image != NULL) ring->image = image;
+    uint8_t *encoded = realloc(ring->encoded, needed);
+    if (encoded != NULL) ring->encoded = encoded;
+    if (key == NULL || image == NULL || encoded == NULL) return false;
+    ring->scratchCapacity = needed;
+    return true;
+}
+
+SnapshotRing *SnapshotRingCreate(int ticks, int budgetBytes, int keyframeInterval) {
+    if (ticks <= 0 || budgetBytes <= 0) return NULL;
+    SnapshotRing *ring = calloc(1, sizeof(SnapshotRing));
+    if (ring == NULL) return NULL;
+    ring->bytes = malloc(budgetBytes);
+    ring->entries = malloc(sizeof(SnapshotEntry) * ticks);
+    if (ring->bytes == NULL || ring->entries == NULL) {
+        SnapshotRingDestroy(ring);
+        return NULL;
+    }
+    ring->budget = budgetBytes;
+    ring->entryCapacity = ticks;
+    ring->keyframeInterval = keyframeInterval > 0 ? keyframeInterval : 1;
+    SnapshotRingReset(ring);
+    return ring;
+}
+
+void SnapshotRingDestroy(SnapshotRing *ring) {
+    if (ring == NULL) return;
+    free(ring->bytes);
+    free(ring->entries);
+    free(ring->key);
+    free(ring->image);
+    free(ring->encoded);
+    free(ring);
+}
+
+void SnapshotRingReset(SnapshotRing *ring) {
+    ring->head = 0;
+    ring->first = 0;
+    ring->count = 0;
+    ring->nextTick = 0;
+    ring->needKey = true;
+}
+
+static SnapshotEntry *EntryAt(const SnapshotRing *ring, int index) {
+    return &ring->entries[(ring->first + index) % ring->entryCapacity];
+}
+
+// The oldest keyframe and the deltas against it
+static void EvictOldest(SnapshotRing *ring) {
+    do {
+        if (EntryAt(ring, 0)->tick == ring->keyTick) ring->needKey = true;
+        ring->first = (ring->first + 1) % ring->entryCapacity;
+        ring->count--;
+    } while (ring->count > 0 && !EntryAt(ring, 0)->keyframe);
+    if (ring->count == 0) ring->head = 0;
+}
+
+// Makes room for size bytes at head, wrapping to the start when the end of
+// the budget is too short. Returns false when it can't fit at all
+static bool MakeRoom(SnapshotRing *ring, int size) {
+    if (size > ring->budget) return false;
+    while (ring->count > 0) {
+        const int tail = EntryAt(ring, 0)->offset;
+        // Newest before oldest: the snapshots in use wrapped around
+        const bool wrapped = EntryAt(ring, ring->count - 1)->offset < tail;
+        if (ring->count < ring->entryCapacity) {
+            if (!wrapped) {
+                // In use: [tail, head)
+                if (ring->head + size <= ring->budget) return true;
+                if (size <= tail) {
+                    ring->head = 0;
+                    return true;
+                }
+            } else if (ring->head + size <= tail) {
+                // In use: [tail, end) and [0, head)
+                return true;
+            }
+        }
+        EvictOldest(ring);
+    }
+    ring->head = 0;
+    return true;
+}
+
+bool SnapshotRingRecord(SnapshotRing *ring, const Game *game) {
+    const size_t size = ImageSize(game);
+    if (size > (size_t)ring->budget || !Reserve(ring, size)) {
+        SnapshotRingReset(ring);
+        return false;
+    }
+    const long long tick = ring->nextTick++;
+    const bool keyframe = ring->needKey || tick - ring->keyTick >= ring->keyframeInterval;
+    WriteImage(ring->image, game);
+    const size_t encodedSize = keyframe ?
+        Encode(ring->encoded, ring->image, size, NULL, 0) :
+        Encode(ring->encoded, ring->image, size, ring->key, ring->keySize);
+    // Evicting can drop the keyframe this delta is against, it's then stored
+    // whole instead
+    if (!MakeRoom(ring, (int)encodedSize) || (!keyframe && ring->needKey)) {
+        if (keyframe) {
+            SnapshotRingReset(ring);
+            return false;
+        }
+        ring->nextTick--;
+        ring->needKey = true;
+        return SnapshotRingRecord(ring, game);
+    }
+    memcpy(ring->bytes + ring->head, ring->encoded, encodedSize);
+    *EntryAt(ring, ring->count) = (SnapshotEntry){
+        .tick = tick,
+        .offset = ring->head,
+        .size = (int)encodedSize,
+        .rawSize = (int)size,
+        .keyframe = keyframe,
+    };
+    ring->count++;
+    ring->head += (int)encodedSize;
+    if (keyframe) {
+        memcpy(ring->key, ring->image, size);
+        ring->keySize = (int)size;
+        ring->keyTick = tick;
+        ring->needKey = false;
+    }
+    return true;
+}
+
+long long SnapshotRingOldest(const SnapshotRing *ring) {
+    return ring->count > 0 ? EntryAt(ring, 0)->tick : -1;
+}
+
+long long SnapshotRingNewest(const SnapshotRing *ring) {
+    return ring->count > 0 ? EntryAt(ring, ring->count - 1)->tick : -1;
+}
+
+int SnapshotRingBytes(const SnapshotRing *ring) {
+    int bytes = 0;
+    for (int i = 0; i < ring->count; i++) {
+        bytes += EntryAt(ring, i)->size;
+    }
+    return bytes;
+}
+
+// Decodes tick into ring->image, returns its size or 0 when it isn't stored
+static size_t DecodeTick(SnapshotRing *ring, long long tick) {
+    const long long oldest = SnapshotRingOldest(ring);
+    if (ring->count == 0 || tick < oldest || tick > SnapshotRingNewest(ring)) return 0;
+    // Ticks are consecutive from the oldest one
+    const int index = (int)(tick - oldest);
+    const SnapshotEntry *entry = EntryAt(ring, index);
+    int keyIndex = index;
+    while (!EntryAt(ring, keyIndex)->keyframe) keyIndex--;
+    const SnapshotEntry *key = EntryAt(ring, keyIndex);
+    if (!Reserve(ring, entry->rawSize > key->rawSize ? entry->rawSize : key->rawSize)) return 0;
+    memset(ring->image, 0, entry->rawSize > key->rawSize ? entry->rawSize : key->rawSize);
+    if (!Decode(ring->image, key->rawSize, ring->bytes + key->offset, key->size)) return 0;
+    // Past the end of the keyframe the delta was against zeros, which the
+    // memset left there
+    if (entry != key) {
+        if (!Decode(ring->image, entry->rawSize, ring->bytes + entry->offset, entry->size)) return 0;
+    }
+    return entry->rawSize;
+}
+
+bool SnapshotRingRestore(SnapshotRing *ring, long long tick, Game *game) {
+    const size_t size = DecodeTick(ring, tick);
+    return size > 0 && ReadImage(ring->image, size, game);
+}
+
+void SnapshotRingTruncate(SnapshotRing *ring, long long tick) {
+    const long long newest = SnapshotRingNewest(ring);
+    if (ring->count == 0 || tick >= newest) return;
+    if (tick < SnapshotRingOldest(ring)) {
+        SnapshotRingReset(ring);
+        ring->nextTick = tick + 1;
+        return;
+    }
+    ring->count -= (int)(newest - tick);
+    const SnapshotEntry *last = EntryAt(ring, ring->count - 1);
+    ring->head = last->offset + last->size;
+    ring->nextTick = tick + 1;
+    // key may be a keyframe that's gone now, the next snapshot starts a new one
+    ring->needKey = true;
+}
+
+static void PutU32(uint8_t *bytes, uint32_t value) {
+    bytes[0] = value & 0xff;
+    bytes[1] = (value >> 8) & 0xff;
+    bytes[2] = (value >> 16) & 0xff;
+    bytes[3] = value >> 24;
+}
+
+static uint32_t GetU32(const uint8_t *bytes) {
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+bool SnapshotRingDump(SnapshotRing *ring, long long tick, const char *path) {
+    const size_t size = DecodeTick(ring, tick);
+    if (size == 0) return false;
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) return false;
+    uint8_t header[24];
+    memcpy(header, "PBSS", 4);
+    PutU32(header + 4, SNAPSHOT_VERSION);
+    PutU32(header + 8, (uint32_t)sizeof(Game));
+    PutU32(header + 12, (uint32_t)tick);
+    PutU32(header + 16, (uint32_t)((unsigned long long)tick >> 32));
+    PutU32(header + 20, (uint32_t)size);
+    fwrite(header, 1, sizeof(header), file);
+    fwrite(ring->image, 1, size, file);
+    const bool ok = ferror(file) == 0;
+    return fclose(file) == 0 && ok;
+}
+
+bool SnapshotLoad(const char *path, Game *game, long long *tick) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return false;
+    uint8_t header[24];
+    bool ok = fread(header, 1, sizeof(header), file) == sizeof(header) &&
+        memcmp(header, "PBSS", 4) == 0 && GetU32(header + 4) == SNAPSHOT_VERSION &&
+        GetU32(header + 8) == sizeof(Game) && GetU32(header + 20) >= sizeof(Game);
+    uint8_t *image = NULL;
+    const size_t size = ok ? GetU32(header + 20) : 0;
+    if (ok) {
+        image = malloc(size);
+        ok = image != NULL && fread(image, 1, size, file) == size && ReadImage(image, size, game);
+    }
+    if (ok && tick != NULL) {
+        *tick = (long long)(GetU32(header + 12) | ((uint64_t)GetU32(header + 16) << 32));
+    }
+    free(image);
+    fclose(file);
+    return ok;
+}
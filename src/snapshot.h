@@ -0,0 +1,53 @@
+#ifndef PIXEL_BLOOM_SNAPSHOT_H
+#define PIXEL_BLOOM_SNAPSHOT_H
+
+// Per-tick snapshots of a Game in a fixed memory budget, for rewinding and
+// for dumping a tick to disk. A snapshot is the Game struct with its
+// allocations left out, followed by the live part of every allocation: the
+// first count particles of each store, the garden's lanes and the weather
+// grids. Every keyframe interval ticks one is stored whole, and the ones in
+// between as the XOR against that keyframe. Both are run-length encoded: a
+// run of zero bytes, then a run of literal bytes, so the bytes a tick didn't
+// change cost next to nothing.
+//
+// When the budget or the tick count runs out, the oldest keyframe goes with
+// every delta that depends on it, so the history covers between the capacity
+// minus one interval and the capacity.
+//
+// Dumps are only meant to be read back by the same build: "PBSS" u32 version
+// u32 sizeof(Game) u64 tick u32 byteCount, then the snapshot, unencoded.
+
+#include <stdbool.h>
+
+#include "sim.h"
+
+#define SNAPSHOT_VERSION 1
+
+typedef struct SnapshotRing SnapshotRing;
+
+// Room for ticks snapshots in budgetBytes of encoded ones. Returns NULL when
+// out of memory
+SnapshotRing *SnapshotRingCreate(int ticks, int budgetBytes, int keyframeInterval);
+void SnapshotRingDestroy(SnapshotRing *ring);
+// Forgets every snapshot, the next one is tick 0
+void SnapshotRingReset(SnapshotRing *ring);
+// Stores the game as the next tick. Returns false when it's bigger than the
+// whole budget or out of memory, the ring then starts over with a keyframe
+bool SnapshotRingRecord(SnapshotRing *ring, const Game *game);
+// Oldest and newest tick stored, -1 when empty
+long long SnapshotRingOldest(const SnapshotRing *ring);
+long long SnapshotRingNewest(const SnapshotRing *ring);
+// Encoded bytes in use, out of budgetBytes
+int SnapshotRingBytes(const SnapshotRing *ring);
+// Puts the game back to how it was at tick, keeping its allocations, job
+// system and window size. Returns false when the tick isn't stored or the
+// game isn't laid out like the one recorded (capacities, garden, weather)
+bool SnapshotRingRestore(SnapshotRing *ring, long long tick, Game *game);
+// Drops every snapshot after tick, recording goes on from there
+void SnapshotRingTruncate(SnapshotRing *ring, long long tick);
+// Returns false when the tick isn't stored or the file can't be written
+bool SnapshotRingDump(SnapshotRing *ring, long long tick, const char *path);
+// Reads a dump into a game laid out like the one dumped, as SnapshotRingRestore
+bool SnapshotLoad(const char *path, Game *game, long long *tick);
+
+#endif // PIXEL_BLOOM_SNAPSHOT_H
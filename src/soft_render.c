@@ -0,0 +1,317 @@
+#include "soft_render.h"
+#include "sprite_sheet.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Same picks as simd.h, for the blend's integer lanes
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SOFT_RENDER_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define SOFT_RENDER_NEON
+#elif defined(__wasm_simd128__)
+    #include <wasm_simd128.h>
+    #define SOFT_RENDER_WASM
+#endif
+
+// Same as DrawNativeFrame, see render.c
+#define BAR_HEIGHT 40
+#define SCORE_X (NATIVE_WIDTH - 30)
+#define SCORE_Y (BAR_HEIGHT - 30)
+
+typedef struct Rgba {
+    uint8_t r, g, b, a;
+} Rgba;
+
+// raylib's DARKGRAY, RAYWHITE, WHITE and LIGHTGRAY
+static const Rgba BACKGROUND = { 80, 80, 80, 255 };
+static const Rgba PARTICLE = { 245, 245, 245, 255 };
+static const Rgba BAR = { 255, 255, 255, 255 };
+static const Rgba SHIELD = { 200, 200, 200, 255 };
+
+// Alpha grows with the field up to these, then the cell is opaque
+static const float WIND_OPAQUE = 4;
+static const float RAIN_OPAQUE = 2;
+
+static void Put(SoftFrame *frame, int x, int y, Rgba color) {
+    memcpy(frame->pixels + (y * NATIVE_WIDTH + x) * 4, &color, 4);
+}
+
+// Rounds like the GPU's pixel centers: a 1x1 quad at x covers pixel floor(x + 0.5)
+static bool PixelOf(float x, float y, int *px, int *py) {
+    const float cx = x + 0.5f;
+    const float cy = y + 0.5f;
+    if (!(cx >= 0 && cx < NATIVE_WIDTH && cy >= 0 && cy < NATIVE_HEIGHT)) return false;
+    *px = (int)cx;
+    *py = (int)cy;
+    return true;
+}
+
+static void DrawParticles(SoftFrame *frame, const ParticleStore *store, float dx, float dy) {
+    for (int i = 0; i < store->count; i++) {
+        int x, y;
+        if (PixelOf(store->x[i] + dx, store->y[i] + dy, &x, &y)) Put(frame, x, y, PARTICLE);
+    }
+}
+
+// Source over an opaque destination, in integers: c = (s*a + d*(255 - a)) / 255
+// rounded to nearest, so both paths below give the same bytes
+static uint8_t BlendChannel(uint8_t s, uint8_t d, uint8_t a) {
+    const unsigned int t = s * a + d * (255u - a) + 128;
+    return (uint8_t)((t + (t >> 8)) >> 8);
+}
+
+#if defined(SOFT_RENDER_SSE2)
+#define SOFT_RENDER_SIMD
+// Two pixels widened to 16 bits a channel
+static __m128i BlendPixels(__m128i s, __m128i d) {
+    __m128i a = _mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(3, 3, 3, 3));
+    const __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), a);
+    const __m128i t = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, inverse)), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// Four pixels. The sheets' alpha is all or nothing, so most blocks take one of
+// the two shortcuts
+static void BlendFour(uint8_t *dst, const uint8_t *src) {
+    const __m128i alphaMask = _mm_set1_epi32((int)0xff000000u);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i s = _mm_loadu_si128((const __m128i *)src);
+    const __m128i alpha = _mm_and_si128(s, alphaMask);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) == 0xffff) return;
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alphaMask)) == 0xffff) {
+        _mm_storeu_si128((__m128i *)dst, s);
+        return;
+    }
+    const __m128i d = _mm_loadu_si128((const __m128i *)dst);
+    const __m128i low = BlendPixels(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+    const __m128i high = BlendPixels(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+    _mm_storeu_si128((__m128i *)dst, _mm_or_si128(_mm_packus_epi16(low, high), alphaMask));
+}
+#elif defined(SOFT_RENDER_NEON)
+#define SOFT_RENDER_SIMD
+// Two pixels, widened to 16 bits a channel by the multiplies
+static uint8x8_t BlendPixels(uint8x8_t s, uint8x8_t d, uint8x8_t a) {
+    uint16x8_t t = vmlal_u8(vmull_u8(s, a), d, vmvn_u8(a));
+    t = vaddq_u16(t, vdupq_n_u16(128));
+    return vshrn_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8);
+}
+
+// Both halves' lanes folded together, a horizontal OR or AND that ARMv7 has too
+static uint64_t OrLanes(uint32x4_t v) {
+    return vget_lane_u64(vreinterpret_u64_u32(vorr_u32(vget_low_u32(v), vget_high_u32(v))), 0);
+}
+
+static uint64_t AndLanes(uint32x4_t v) {
+    return vget_lane_u64(vreinterpret_u64_u32(vand_u32(vget_low_u32(v), vget_high_u32(v))), 0);
+}
+
+// Four pixels, with the same two shortcuts as the SSE2 path
+static void BlendFour(uint8_t *dst, const uint8_t *src) {
+    const uint32x4_t alphaMask = vdupq_n_u32(0xff000000u);
+    const uint8x16_t s = vld1q_u8(src);
+    const uint32x4_t alpha = vandq_u32(vreinterpretq_u32_u8(s), alphaMask);
+    if (OrLanes(alpha) == 0) return;
+    if (AndLanes(alpha) == 0xff000000ff000000u) {
+        vst1q_u8(dst, s);
+        return;
+    }
+    // Every byte of a pixel set to its alpha
+    const uint8x16_t a = vreinterpretq_u8_u32(vmulq_n_u32(vshrq_n_u32(alpha, 24), 0x01010101u));
+    const uint8x16_t d = vld1q_u8(dst);
+    const uint8x8_t low = BlendPixels(vget_low_u8(s), vget_low_u8(d), vget_low_u8(a));
+    const uint8x8_t high = BlendPixels(vget_high_u8(s), vget_high_u8(d), vget_high_u8(a));
+    vst1q_u8(dst, vorrq_u8(vcombine_u8(low, high), vreinterpretq_u8_u32(alphaMask)));
+}
+#elif defined(SOFT_RENDER_WASM)
+#define SOFT_RENDER_SIMD
+// Two pixels widened to 16 bits a channel
+static v128_t BlendPixels(v128_t s, v128_t d, v128_t a) {
+    const v128_t inverse = wasm_i16x8_sub(wasm_i16x8_splat(255), a);
+    const v128_t t = wasm_i16x8_add(wasm_i16x8_add(wasm_i16x8_mul(s, a), wasm_i16x8_mul(d, inverse)), wasm_i16x8_splat(128));
+    return wasm_u16x8_shr(wasm_i16x8_add(t, wasm_u16x8_shr(t, 8)), 8);
+}
+
+// Four pixels, with the same two shortcuts as the SSE2 path
+static void BlendFour(uint8_t *dst, const uint8_t *src) {
+    const v128_t alphaMask = wasm_i32x4_splat((int)0xff000000u);
+    const v128_t s = wasm_v128_load(src);
+    const v128_t alpha = wasm_v128_and(s, alphaMask);
+    if (!wasm_v128_any_true(alpha)) return;
+    if (wasm_i32x4_all_true(wasm_i32x4_eq(alpha, alphaMask))) {
+        wasm_v128_store(dst, s);
+        return;
+    }
+    const v128_t a = wasm_i8x16_shuffle(s, s, 3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15);
+    const v128_t d = wasm_v128_load(dst);
+    const v128_t low = BlendPixels(wasm_u16x8_extend_low_u8x16(s), wasm_u16x8_extend_low_u8x16(d), wasm_u16x8_extend_low_u8x16(a));
+    const v128_t high = BlendPixels(wasm_u16x8_extend_high_u8x16(s), wasm_u16x8_extend_high_u8x16(d), wasm_u16x8_extend_high_u8x16(a));
+    wasm_v128_store(dst, wasm_v128_or(wasm_u8x16_narrow_i16x8(low, high), alphaMask));
+}
+#endif
+
+static void BlendRow(uint8_t *dst, const uint8_t *src, int count) {
+    int i = 0;
+#if defined(SOFT_RENDER_SIMD)
+    for (; i + 4 <= count; i += 4) {
+        BlendFour(dst + (size_t)i * 4, src + (size_t)i * 4);
+    }
+#endif
+    for (; i < count; i++) {
+        const uint8_t *s = src + (size_t)i * 4;
+        uint8_t *d = dst + (size_t)i * 4;
+        const uint8_t a = s[3];
+        if (a == 0) continue;
+        d[0] = BlendChannel(s[0], d[0], a);
+        d[1] = BlendChannel(s[1], d[1], a);
+        d[2] = BlendChannel(s[2], d[2], a);
+        d[3] = 255;
+    }
+}
+
+// One row of the weather layer: the particle color, as opaque as the cell is full
+static void WeatherRow(uint8_t *row, const Game *game, int y) {
+    const float *grid = game->isSunUp ? game->weather.wind : game->weather.rain;
+    const float scale = 255 / (game->isSunUp ? WIND_OPAQUE : RAIN_OPAQUE);
+    const float *cells = grid + WeatherCell(0, y);
+    for (int x = 0; x < NATIVE_WIDTH; x++) {
+        const float alpha = cells[x] * scale;
+        row[x * 4 + 0] = PARTICLE.r;
+        row[x * 4 + 1] = PARTICLE.g;
+        row[x * 4 + 2] = PARTICLE.b;
+        row[x * 4 + 3] = alpha >= 255 ? 255 : (uint8_t)alpha;
+    }
+}
+
+void SoftRenderWeather(uint8_t *pixels, const Game *game) {
+    for (int y = 0; y < NATIVE_HEIGHT; y++) {
+        WeatherRow(pixels + y * NATIVE_WIDTH * 4, game, y);
+    }
+}
+
+static void DrawWeather(SoftFrame *frame, const Game *game) {
+    uint8_t row[NATIVE_WIDTH * 4];
+    for (int y = 0; y < NATIVE_HEIGHT; y++) {
+        WeatherRow(row, game, y);
+        BlendRow(frame->pixels + y * NATIVE_WIDTH * 4, row, NATIVE_WIDTH);
+    }
+}
+
+// One frame of the sheet with its top left corner at x, y, clipped to the frame
+static void Blit(SoftFrame *frame, SpriteId sprite, int spriteFrame, int x, int y) {
+    const SpriteRect source = SpriteFrameRect(sprite, spriteFrame);
+    const int left = x < 0 ? -x : 0;
+    const int top = y < 0 ? -y : 0;
+    const int right = x + source.width > NATIVE_WIDTH ? NATIVE_WIDTH - x : source.width;
+    const int bottom = y + source.height > NATIVE_HEIGHT ? NATIVE_HEIGHT - y : source.height;
+    if (left >= right || top >= bottom) return;
+    const unsigned char *sheet = SpriteSheetPixels();
+    const int sheetWidth = SpriteSheetWidth();
+    for (int row = top; row < bottom; row++) {
+        const uint8_t *src = sheet + ((source.y + row) * sheetWidth + source.x + left) * 4;
+        uint8_t *dst = frame->pixels + ((y + row) * NATIVE_WIDTH + x + left) * 4;
+        BlendRow(dst, src, right - left);
+    }
+}
+
+// Bars grow up from the bottom edge. A row is filled when its center is inside,
+// like the GPU fills the rectangle
+static void DrawBar(SoftFrame *frame, int x, float height) {
+    const float top = NATIVE_HEIGHT - height;
+    for (int y = 0; y < NATIVE_HEIGHT; y++) {
+        if (y + 0.5f < top) continue;
+        for (int i = 0; i < 4; i++) {
+            Put(frame, x + i, y, BAR);
+        }
+    }
+}
+
+static void DrawShield(SoftFrame *frame, Vector2 center) {
+    const float radius = (float)SHIELD_RADIUS;
+    const int left = (int)(center.x - radius) - 1;
+    const int top = (int)(center.y - radius) - 1;
+    for (int y = top; y <= top + 2 * SHIELD_RADIUS + 2; y++) {
+        if (y < 0 || y >= NATIVE_HEIGHT) continue;
+        for (int x = left; x <= left + 2 * SHIELD_RADIUS + 2; x++) {
+            if (x < 0 || x >= NATIVE_WIDTH) continue;
+            const float dx = x + 0.5f - center.x;
+            const float dy = y + 0.5f - center.y;
+            if (dx * dx + dy * dy <= radius * radius) Put(frame, x, y, SHIELD);
+        }
+    }
+}
+
+// 3x5 glyphs, one row a number with the leftmost pixel in bit 2
+static const uint8_t *Glyph(char c) {
+    static const uint8_t digits[10][5] = {
+        { 7, 5, 5, 5, 7 }, { 2, 6, 2, 2, 7 }, { 7, 1, 7, 4, 7 }, { 7, 1, 7, 1, 7 }, { 5, 5, 7, 1, 1 },
+        { 7, 4, 7, 1, 7 }, { 7, 4, 7, 5, 7 }, { 7, 1, 1, 1, 1 }, { 7, 5, 7, 5, 7 }, { 7, 5, 7, 1, 7 },
+    };
+    static const uint8_t dollar[5] = { 3, 6, 2, 3, 6 };
+    static const uint8_t colon[5] = { 0, 2, 0, 2, 0 };
+    if (c >= '0' && c <= '9') return digits[c - '0'];
+    if (c == '$') return dollar;
+    if (c == ':') return colon;
+    return NULL;
+}
+
+static void DrawHudText(SoftFrame *frame, const char *text, int x, int y) {
+    for (; *text != '\0'; text++, x += 4) {
+        const uint8_t *glyph = Glyph(*text);
+        if (glyph == NULL) continue;
+        for (int row = 0; row < 5; row++) {
+            for (int column = 0; column < 3; column++) {
+                const int px = x + column;
+                if ((glyph[row] >> (2 - column) & 1) && px < NATIVE_WIDTH) Put(frame, px, y + row, BAR);
+            }
+        }
+    }
+}
+
+void SoftRenderFrame(SoftFrame *frame, const Game *game, float lag, bool shields) {
+    for (int i = 0; i < NATIVE_WIDTH * NATIVE_HEIGHT; i++) {
+        memcpy(frame->pixels + i * 4, &BACKGROUND, 4);
+    }
+    // The field moves under a pixel a tick, it is drawn as it is
+    if (game->weather.wind != NULL) DrawWeather(frame, game);
+    if (game->isSunUp) {
+        DrawParticles(frame, &game->wind, -lag, 0);
+        Blit(frame, SpriteSun, game->sun.currentFrame, 0, 0);
+    } else {
+        DrawParticles(frame, &game->water, 0, -WATER_FALL_SPEED * lag);
+        Blit(frame, SpriteCloud, game->cloud.currentFrame, 40, 0);
+    }
+    const SpriteRect flowerFrame = SpriteFrameRect(SpriteFlower, game->flower.currentFrame);
+    Blit(frame, SpriteFlower, game->flower.currentFrame, 60, NATIVE_HEIGHT - flowerFrame.height);
+
+    DrawBar(frame, NATIVE_WIDTH - 20, BAR_HEIGHT * game->flower.health / 100);
+    DrawBar(frame, NATIVE_WIDTH - 10, BAR_HEIGHT * game->flower.waterLevel / FLOWER_MAX_WATER_LEVEL);
+    Blit(frame, SpriteHealth, 0, NATIVE_WIDTH - 22, NATIVE_HEIGHT - BAR_HEIGHT - 10);
+    Blit(frame, SpriteWater, 0, NATIVE_WIDTH - 12, NATIVE_HEIGHT - BAR_HEIGHT - 10);
+    char score[16];
+    snprintf(score, sizeof(score), "$: %03d", (int)(game->score + 0.5f));
+    DrawHudText(frame, score, SCORE_X, SCORE_Y);
+
+    for (int i = 0; shields && i < game->shieldCount; i++) {
+        DrawShield(frame, game->shields[i]);
+    }
+}
+
+bool SoftFrameWritePPM(const SoftFrame *frame, const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) return false;
+    fprintf(file, "P6\n%d %d\n255\n", NATIVE_WIDTH, NATIVE_HEIGHT);
+    uint8_t row[NATIVE_WIDTH * 3];
+    for (int y = 0; y < NATIVE_HEIGHT; y++) {
+        const uint8_t *src = frame->pixels + y * NATIVE_WIDTH * 4;
+        for (int x = 0; x < NATIVE_WIDTH; x++) {
+            memcpy(row + x * 3, src + x * 4, 3);
+        }
+        fwrite(row, sizeof(row), 1, file);
+    }
+    const bool written = !ferror(file);
+    return fclose(file) == 0 && written;
+}
@@ -0,0 +1,31 @@
+#ifndef PIXEL_BLOOM_SOFT_RENDER_H
+#define PIXEL_BLOOM_SOFT_RENDER_H
+
+// Draws a Game into a 160x90 pixel buffer on the CPU: the same scene as
+// DrawNativeFrame, composited from the sprite sheet's pixels with no GL. The
+// game uploads the buffer as one texture a frame (--soft-render), and
+// pixel-bloom-frames writes it to disk, which gives CI exact frames to diff.
+//
+// Matches the GPU frame pixel for pixel except the HUD score, which uses a
+// built-in 3x5 font instead of raylib's.
+
+#include "sim.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct SoftFrame {
+    uint8_t pixels[NATIVE_WIDTH * NATIVE_HEIGHT * 4];   // RGBA8, rows top to bottom
+} SoftFrame;
+
+// lag and shields as in DrawNativeFrame: particles are drawn where they were
+// lag seconds before the last tick. Garden mode isn't drawn, only the native scene
+void SoftRenderFrame(SoftFrame *frame, const Game *game, float lag, bool shields);
+// Field weather alone (weather.h) over a transparent background, same layout
+// as a SoftFrame: what SoftRenderFrame blends over the scene in field mode,
+// and what DrawNativeFrame uploads to a texture
+void SoftRenderWeather(uint8_t *pixels, const Game *game);
+// Binary PPM (P6), alpha dropped. Returns false when the file can't be written
+bool SoftFrameWritePPM(const SoftFrame *frame, const char *path);
+
+#endif // PIXEL_BLOOM_SOFT_RENDER_H
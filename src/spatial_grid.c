@@ -0,0 +1,120 @@
+#include "spatial_grid.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int ClampInt(int value, int min, int max) {
+    return value < min ? min : (value > max ? max : value);
+}
+
+// Particles outside the space go to the border cells, so nothing is missed
+static int ColumnOf(const SpatialGrid *grid, float x) {
+    return ClampInt((int)(x / GRID_CELL_SIZE), 0, grid->columns - 1);
+}
+
+static int RowOf(const SpatialGrid *grid, float y) {
+    return ClampInt((int)(y / GRID_CELL_SIZE), 0, grid->rows - 1);
+}
+
+static int BucketOf(const SpatialGrid *grid, int column, int row) {
+    return (row * grid->columns + column) & grid->bucketMask;
+}
+
+// A bucket per cell when that's no more than one per particle
+static int BucketsFor(const SpatialGrid *grid, int count) {
+    const int64_t cells = (int64_t)grid->columns * grid->rows;
+    const int64_t wanted = cells < count ? cells : count;
+    int buckets = GRID_MIN_BUCKETS;
+    while (buckets < wanted) buckets *= 2;
+    return buckets;
+}
+
+bool SpatialGridInit(SpatialGrid *grid, int capacity, float width, float height) {
+    *grid = (SpatialGrid){0};
+    grid->columns = (int)ceilf(width / GRID_CELL_SIZE);
+    grid->rows = (int)ceilf(height / GRID_CELL_SIZE);
+    if (grid->columns < 1) grid->columns = 1;
+    if (grid->rows < 1) grid->rows = 1;
+    // Cell numbers are ints
+    if ((int64_t)grid->columns * grid->rows > INT32_MAX) return false;
+    const int buckets = BucketsFor(grid, capacity);
+    grid->bucketMask = buckets - 1;
+    grid->bucketStart = malloc(sizeof(int) * ((size_t)buckets + 1));
+    grid->cursor = malloc(sizeof(int) * (size_t)buckets);
+    grid->indices = malloc(sizeof(int) * capacity);
+    grid->bucketOf = malloc(sizeof(int) * capacity);
+    grid->x = malloc(sizeof(float) * capacity);
+    grid->y = malloc(sizeof(float) * capacity);
+    if (grid->bucketStart == NULL || grid->cursor == NULL || grid->indices == NULL || grid->bucketOf == NULL ||
+        grid->x == NULL || grid->y == NULL) {
+        SpatialGridFree(grid);
+        return false;
+    }
+    grid->capacity = capacity;
+    return true;
+}
+
+void SpatialGridFree(SpatialGrid *grid) {
+    free(grid->bucketStart);
+    free(grid->cursor);
+    free(grid->indices);
+    free(grid->bucketOf);
+    free(grid->x);
+    free(grid->y);
+    *grid = (SpatialGrid){0};
+}
+
+void SpatialGridUpdate(SpatialGrid *grid, const ParticleStore *store) {
+    const int count = store->count < grid->capacity ? store->count : grid->capacity;
+    // Sized to the particles alive now, so an emptier store sorts faster
+    const int buckets = BucketsFor(grid, count);
+    grid->bucketMask = buckets - 1;
+    memset(grid->cursor, 0, sizeof(int) * (size_t)buckets);
+    for (int i = 0; i < count; i++) {
+        const int bucket = BucketOf(grid, ColumnOf(grid, store->x[i]), RowOf(grid, store->y[i]));
+        grid->bucketOf[i] = bucket;
+        grid->cursor[bucket]++;
+    }
+    int start = 0;
+    for (int b = 0; b < buckets; b++) {
+        const int size = grid->cursor[b];
+        grid->bucketStart[b] = start;
+        grid->cursor[b] = start;
+        start += size;
+    }
+    grid->bucketStart[buckets] = start;
+    for (int i = 0; i < count; i++) {
+        const int k = grid->cursor[grid->bucketOf[i]]++;
+        grid->indices[k] = i;
+        grid->x[k] = store->x[i];
+        grid->y[k] = store->y[i];
+    }
+    grid->count = count;
+}
+
+int SpatialGridMarkCircle(const SpatialGrid *grid, ParticleStore *store, float x, float y, float radius) {
+    const float radius2 = radius * radius;
+    const int firstColumn = ColumnOf(grid, x - radius);
+    const int lastColumn = ColumnOf(grid, x + radius);
+    const int firstRow = RowOf(grid, y - radius);
+    const int lastRow = RowOf(grid, y + radius);
+    int marked = 0;
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int column = firstColumn; column <= lastColumn; column++) {
+            // A bucket two of these cells share is tested twice, but only marks once
+            const int bucket = BucketOf(grid, column, row);
+            for (int k = grid->bucketStart[bucket]; k < grid->bucketStart[bucket + 1]; k++) {
+                const float dx = grid->x[k] - x;
+                const float dy = grid->y[k] - y;
+                if (dx * dx + dy * dy > radius2) continue;
+                const int i = grid->indices[k];
+                if (store->hits[i] == ParticleHitNone) {
+                    store->hits[i] = ParticleHitShield;
+                    marked++;
+                }
+            }
+        }
+    }
+    return marked;
+}
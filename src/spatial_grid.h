@@ -0,0 +1,50 @@
+#ifndef PIXEL_BLOOM_SPATIAL_GRID_H
+#define PIXEL_BLOOM_SPATIAL_GRID_H
+
+// Uniform bucket grid for shield queries, over the space the particles live
+// in: the native 160x90 scene, or a whole garden. SpatialGridUpdate buckets
+// every particle with one counting sort, two linear passes: particles move
+// and die every tick, so there's no layout worth keeping from the last one. A
+// circle query then visits just the cells under the circle's bounding box.
+//
+// A garden has far more cells than particles, and sorting into all of them
+// would cost more than the particles do. Cells are numbered row by row and
+// wrapped into a power of two table of buckets, about one per live particle, so
+// some far apart cells share a bucket. The query's distance test sorts them
+// out. On one screen every cell has a bucket of its own.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "particles.h"
+
+// A shield (radius 5) overlaps at most 4x4 cells of this size
+#define GRID_CELL_SIZE 4
+// Buckets, at least: the cells of the native scene
+#define GRID_MIN_BUCKETS 1024
+
+typedef struct SpatialGrid {
+    int *bucketStart;   // particles of bucket b are indices[bucketStart[b] .. bucketStart[b + 1])
+    int *cursor;        // scratch: particles per bucket, then where the next one goes
+    int *indices;       // particle indices ordered by bucket
+    float *x;           // positions in the same order, so queries read
+    float *y;           // each bucket as one contiguous run
+    int *bucketOf;      // scratch: bucket of every particle, between the two passes
+    int columns;        // cells per row over the whole space
+    int rows;
+    int bucketMask;     // buckets the last update used - 1
+    int count;          // particles bucketed by the last update
+    int capacity;
+} SpatialGrid;
+
+// Room for capacity particles in a width x height space. Particles outside it
+// go to the border cells, so nothing is missed
+bool SpatialGridInit(SpatialGrid *grid, int capacity, float width, float height);
+void SpatialGridFree(SpatialGrid *grid);
+// Buckets particles [0, count) of the store
+void SpatialGridUpdate(SpatialGrid *grid, const ParticleStore *store);
+// Marks every particle inside the circle that has no hit yet as a shield hit,
+// returns how many it marked
+int SpatialGridMarkCircle(const SpatialGrid *grid, ParticleStore *store, float x, float y, float radius);
+
+#endif // PIXEL_BLOOM_SPATIAL_GRID_H
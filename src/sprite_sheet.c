@@ -0,0 +1,36 @@
+#include "sprite_sheet.h"
+#include "sim.h"
+
+typedef struct AtlasSprite {
+    int firstFrame;     // index into atlasFrames
+    int frameCount;
+} AtlasSprite;
+
+// Generated into the build directory from resources/*.png
+#include "atlas_data.h"
+
+// The sim animates by its counts, the atlas slices by PIXEL_BLOOM_ATLAS_SHEETS
+_Static_assert(ATLAS_FLOWER_FRAMES == FLOWER_FRAMES, "flower frames in PIXEL_BLOOM_ATLAS_SHEETS don't match sim.h");
+_Static_assert(ATLAS_SUN_FRAMES == SUN_FRAMES, "sun frames in PIXEL_BLOOM_ATLAS_SHEETS don't match sim.h");
+_Static_assert(ATLAS_CLOUD_FRAMES == CLOUD_FRAMES, "cloud frames in PIXEL_BLOOM_ATLAS_SHEETS don't match sim.h");
+
+const unsigned char *SpriteSheetPixels(void) {
+    return atlasPixels;
+}
+
+int SpriteSheetWidth(void) {
+    return ATLAS_WIDTH;
+}
+
+int SpriteSheetHeight(void) {
+    return ATLAS_HEIGHT;
+}
+
+int SpriteFrameCount(SpriteId sprite) {
+    return atlasSprites[sprite].frameCount;
+}
+
+SpriteRect SpriteFrameRect(SpriteId sprite, int frame) {
+    const AtlasSprite entry = atlasSprites[sprite];
+    return atlasFrames[entry.firstFrame + frame % entry.frameCount];
+}
@@ -0,0 +1,34 @@
+#ifndef PIXEL_BLOOM_SPRITE_SHEET_H
+#define PIXEL_BLOOM_SPRITE_SHEET_H
+
+// The packed sprite atlas as plain data: RGBA8 pixels and the frame table,
+// with no raylib or GL in sight. atlas.h uploads it as a texture, the
+// software renderer (soft_render.h) blits from it directly.
+
+// Must match the sheet order of PIXEL_BLOOM_ATLAS_SHEETS, SpriteWhite is added by the packer
+typedef enum SpriteId {
+    SpriteFlower = 0,
+    SpriteSun,
+    SpriteCloud,
+    SpriteHealth,
+    SpriteWater,
+    SpriteWhite,    // 3x3 white block, the shapes texture
+    SpriteCount,
+} SpriteId;
+
+typedef struct SpriteRect {
+    int x;
+    int y;
+    int width;
+    int height;
+} SpriteRect;
+
+// Rows top to bottom, SpriteSheetWidth() * 4 bytes each
+const unsigned char *SpriteSheetPixels(void);
+int SpriteSheetWidth(void);
+int SpriteSheetHeight(void);
+int SpriteFrameCount(SpriteId sprite);
+// Where one frame sits in the sheet, wraps around the sprite's frame count
+SpriteRect SpriteFrameRect(SpriteId sprite, int frame);
+
+#endif // PIXEL_BLOOM_SPRITE_SHEET_H
@@ -0,0 +1,133 @@
+#include "ui.h"
+
+#include <string.h>
+
+// raylib's default font doesn't go below this
+#define UI_MIN_FONT_SIZE 10
+
+static const int BUTTON_FONT_SIZE = 20;
+static const int BUTTON_TEXT_INSET = 20;
+
+// Labels are exactly as big as their text
+static void SizeLabel(Widget *widget) {
+    if (widget->clickable) return;
+    const int height = widget->fontSize < UI_MIN_FONT_SIZE ? UI_MIN_FONT_SIZE : widget->fontSize;
+    widget->bounds.width = (float)MeasureText(widget->text, widget->fontSize);
+    widget->bounds.height = (float)height;
+}
+
+Widget UiButton(const char *text) {
+    Widget widget = {
+        .fontSize = BUTTON_FONT_SIZE,
+        .background = GRAY,
+        .foreground = WHITE,
+        .clickable = true,
+        .visible = true,
+        .dirty = true,
+    };
+    strncpy(widget.text, text, UI_MAX_TEXT - 1);
+    return widget;
+}
+
+Widget UiLabel(const char *text, int fontSize, Color color) {
+    Widget widget = {
+        .fontSize = fontSize,
+        .background = BLANK,
+        .foreground = color,
+        .visible = true,
+        .dirty = true,
+    };
+    strncpy(widget.text, text, UI_MAX_TEXT - 1);
+    SizeLabel(&widget);
+    return widget;
+}
+
+int UiAdd(UiLayer *ui, Widget widget) {
+    if (ui->count == UI_MAX_WIDGETS) return -1;
+    ui->widgets[ui->count] = widget;
+    return ui->count++;
+}
+
+void WidgetSetText(Widget *widget, const char *text) {
+    if (strncmp(widget->text, text, UI_MAX_TEXT - 1) == 0) return;
+    strncpy(widget->text, text, UI_MAX_TEXT - 1);
+    widget->text[UI_MAX_TEXT - 1] = '\0';
+    SizeLabel(widget);
+    widget->dirty = true;
+}
+
+void WidgetSetBounds(Widget *widget, Rectangle bounds) {
+    if (!widget->clickable) {
+        widget->bounds.x = bounds.x;
+        widget->bounds.y = bounds.y;
+        return;
+    }
+    // Moving is free, only a new size needs the texture drawn again
+    if ((int)bounds.width != (int)widget->bounds.width || (int)bounds.height != (int)widget->bounds.height) {
+        widget->dirty = true;
+    }
+    widget->bounds = bounds;
+}
+
+void WidgetRefresh(Widget *widget) {
+    if (!widget->dirty) return;
+    const int width = (int)widget->bounds.width;
+    const int height = (int)widget->bounds.height;
+    if (width <= 0 || height <= 0) {
+        // Nothing to show, e.g. a label emptied: drop the old text's texture
+        WidgetUnload(widget);
+        widget->dirty = false;
+        return;
+    }
+    if (widget->texture.id == 0 || widget->texture.texture.width != width || widget->texture.texture.height != height) {
+        if (widget->texture.id != 0) UnloadRenderTexture(widget->texture);
+        widget->texture = LoadRenderTexture(width, height);
+    }
+    const int x = widget->clickable ? BUTTON_TEXT_INSET : 0;
+    const int y = widget->clickable ? height / 2 - BUTTON_FONT_SIZE / 2 : 0;
+    BeginTextureMode(widget->texture);
+        ClearBackground(widget->background);
+        DrawText(widget->text, x, y, widget->fontSize, widget->foreground);
+    EndTextureMode();
+    widget->dirty = false;
+}
+
+void UiRefresh(UiLayer *ui) {
+    for (int i = 0; i < ui->count; i++) {
+        if (ui->widgets[i].visible) WidgetRefresh(&ui->widgets[i]);
+    }
+}
+
+void WidgetDraw(const Widget *widget) {
+    if (widget->texture.id == 0) return;
+    const Texture2D texture = widget->texture.texture;
+    // Render textures are stored upside down
+    DrawTextureRec(texture, (Rectangle){ 0, 0, (float)texture.width, (float)-texture.height },
+        (Vector2){ widget->bounds.x, widget->bounds.y }, WHITE);
+}
+
+void UiDraw(const UiLayer *ui) {
+    for (int i = 0; i < ui->count; i++) {
+        if (ui->widgets[i].visible) WidgetDraw(&ui->widgets[i]);
+    }
+}
+
+int UiHitTest(const UiLayer *ui, Vector2 point) {
+    for (int i = ui->count - 1; i >= 0; i--) {
+        const Widget *widget = &ui->widgets[i];
+        if (widget->visible && widget->clickable && CheckCollisionPointRec(point, widget->bounds)) return i;
+    }
+    return -1;
+}
+
+void WidgetUnload(Widget *widget) {
+    if (widget->texture.id != 0) UnloadRenderTexture(widget->texture);
+    widget->texture = (RenderTexture2D){0};
+    widget->dirty = true;
+}
+
+void UiUnload(UiLayer *ui) {
+    for (int i = 0; i < ui->count; i++) {
+        WidgetUnload(&ui->widgets[i]);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef PIXEL_BLOOM_UI_H
+#define PIXEL_BLOOM_UI_H
+
+// Retained widgets. Each one keeps its background and text rasterized in its
+// own render texture, drawn again only when the text or size changes, so a
+// frame just blits a quad per visible widget. Layout happens when the window
+// changes (WidgetSetBounds), and clicks are tested against the bounds stored
+// then.
+
+#include <stdbool.h>
+
+#include "raylib.h"
+
+#define UI_MAX_WIDGETS 16
+#define UI_MAX_TEXT 64
+
+typedef struct Widget {
+    Rectangle bounds;       // screen position, labels size themselves to their text
+    char text[UI_MAX_TEXT];
+    int fontSize;
+    Color background;       // BLANK for labels
+    Color foreground;
+    bool clickable;         // buttons: clickable, text inset like the old MenuButtom
+    bool visible;
+    bool dirty;             // the texture doesn't show the text and size yet
+    RenderTexture2D texture;
+} Widget;
+
+typedef struct UiLayer {
+    Widget widgets[UI_MAX_WIDGETS];
+    int count;
+} UiLayer;
+
+Widget UiButton(const char *text);
+Widget UiLabel(const char *text, int fontSize, Color color);
+// Returns the widget's index, or -1 when the layer is full
+int UiAdd(UiLayer *ui, Widget widget);
+// Only marks the widget dirty when the text actually changes
+void WidgetSetText(Widget *widget, const char *text);
+// Labels only take the position
+void WidgetSetBounds(Widget *widget, Rectangle bounds);
+// Re-rasterizes dirty widgets, call outside BeginTextureMode/EndTextureMode
+void WidgetRefresh(Widget *widget);
+void UiRefresh(UiLayer *ui);
+void WidgetDraw(const Widget *widget);
+// Visible widgets only
+void UiDraw(const UiLayer *ui);
+// Topmost visible clickable widget under point, -1 for none
+int UiHitTest(const UiLayer *ui, Vector2 point);
+void WidgetUnload(Widget *widget);
+void UiUnload(UiLayer *ui);
+
+#endif // PIXEL_BLOOM_UI_H
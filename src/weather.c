@@ -0,0 +1,175 @@
+#include "weather.h"
+#include "simd.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// Past this a tick is a hitch, not weather: the rest of it is dropped
+#define WEATHER_MAX_SUBSTEPS 16
+// Diffusion spreads every gust thinner forever. Below this a cell is cleared,
+// before its value decays into denormals, which are many times slower
+#define WEATHER_EPSILON 1e-4f
+
+bool WeatherFieldInit(WeatherField *field) {
+    *field = (WeatherField){0};
+    // calloc, so the border cells start and stay 0: the steps only write inside
+    field->wind = calloc(WEATHER_CELLS, sizeof(float));
+    field->rain = calloc(WEATHER_CELLS, sizeof(float));
+    field->next = calloc(WEATHER_CELLS, sizeof(float));
+    field->open = calloc(WEATHER_CELLS, sizeof(float));
+    if (field->wind == NULL || field->rain == NULL || field->next == NULL || field->open == NULL) {
+        WeatherFieldFree(field);
+        return false;
+    }
+    WeatherFieldClear(field);
+    return true;
+}
+
+void WeatherFieldFree(WeatherField *field) {
+    free(field->wind);
+    free(field->rain);
+    free(field->next);
+    free(field->open);
+    *field = (WeatherField){0};
+}
+
+void WeatherFieldClear(WeatherField *field) {
+    for (int i = 0; i < WEATHER_CELLS; i++) {
+        field->wind[i] = 0;
+        field->rain[i] = 0;
+    }
+    field->caughtWater = 0;
+    WeatherFieldClearObstacles(field);
+}
+
+void WeatherFieldClearObstacles(WeatherField *field) {
+    for (int i = 0; i < WEATHER_CELLS; i++) {
+        field->open[i] = 1;
+    }
+}
+
+// A cell is inside when its center is, like the shield is drawn
+void WeatherFieldAddObstacle(WeatherField *field, float x, float y, float radius) {
+    const int left = (int)floorf(x - radius);
+    const int top = (int)floorf(y - radius);
+    const int right = (int)ceilf(x + radius);
+    const int bottom = (int)ceilf(y + radius);
+    for (int cy = top < 0 ? 0 : top; cy <= bottom && cy < WEATHER_HEIGHT; cy++) {
+        for (int cx = left < 0 ? 0 : left; cx <= right && cx < WEATHER_WIDTH; cx++) {
+            const float dx = cx + 0.5f - x;
+            const float dy = cy + 0.5f - y;
+            if (dx * dx + dy * dy <= radius * radius) field->open[WeatherCell(cx, cy)] = 0;
+        }
+    }
+}
+
+static WeatherRect Clip(WeatherRect rect) {
+    if (rect.x < 0) { rect.width += rect.x; rect.x = 0; }
+    if (rect.y < 0) { rect.height += rect.y; rect.y = 0; }
+    if (rect.x + rect.width > WEATHER_WIDTH) rect.width = WEATHER_WIDTH - rect.x;
+    if (rect.y + rect.height > WEATHER_HEIGHT) rect.height = WEATHER_HEIGHT - rect.y;
+    if (rect.width < 0) rect.width = 0;
+    if (rect.height < 0) rect.height = 0;
+    return rect;
+}
+
+static void Add(float *grid, WeatherRect rect, float value) {
+    rect = Clip(rect);
+    for (int y = rect.y; y < rect.y + rect.height; y++) {
+        for (int x = rect.x; x < rect.x + rect.width; x++) {
+            grid[WeatherCell(x, y)] += value;
+        }
+    }
+}
+
+void WeatherFieldAddWind(WeatherField *field, WeatherRect rect, float power) {
+    Add(field->wind, rect, power);
+}
+
+void WeatherFieldAddRain(WeatherField *field, WeatherRect rect, float amount) {
+    Add(field->rain, rect, amount);
+}
+
+// One row of a substep: every cell passes c of itself on to the neighbour
+// offset cells downwind and keeps the rest, then diffuses with its four
+// neighbours, and obstacles and traces zero whatever came in
+static void AdvectRow(float *out, const float *q, const float *open, int begin, int end, int offset, float c, float k) {
+    int i = begin;
+#if !defined(SIMD_SCALAR)
+    const SimdFloat vc = SimdSet1(c);
+    const SimdFloat vk = SimdSet1(k);
+    const SimdFloat four = SimdSet1(4);
+    const SimdFloat epsilon = SimdSet1(WEATHER_EPSILON);
+    for (; i + SIMD_WIDTH <= end; i += SIMD_WIDTH) {
+        const SimdFloat center = SimdLoad(q + i);
+        const SimdFloat upwind = SimdLoad(q + i - offset);
+        const SimdFloat left = SimdLoad(q + i - 1);
+        const SimdFloat right = SimdLoad(q + i + 1);
+        const SimdFloat up = SimdLoad(q + i - WEATHER_STRIDE);
+        const SimdFloat down = SimdLoad(q + i + WEATHER_STRIDE);
+        const SimdFloat laplacian = SimdSub(SimdAdd(SimdAdd(left, right), SimdAdd(up, down)), SimdMul(center, four));
+        const SimdFloat advected = SimdAdd(SimdSub(center, SimdMul(vc, center)), SimdMul(vc, upwind));
+        const SimdFloat value = SimdMul(SimdAdd(advected, SimdMul(vk, laplacian)), SimdLoad(open + i));
+        SimdStore(out + i, SimdAnd(value, SimdGreater(value, epsilon)));
+    }
+#endif
+    for (; i < end; i++) {
+        const float center = q[i];
+        const float laplacian = ((q[i - 1] + q[i + 1]) + (q[i - WEATHER_STRIDE] + q[i + WEATHER_STRIDE])) - center * 4;
+        const float advected = (center - c * center) + c * q[i - offset];
+        const float value = (advected + k * laplacian) * open[i];
+        out[i] = value > WEATHER_EPSILON ? value : 0;
+    }
+}
+
+// Takes everything in the sink's cells out of the grid
+static float Drain(float *grid, WeatherRect sink) {
+    sink = Clip(sink);
+    float caught = 0;
+    for (int y = sink.y; y < sink.y + sink.height; y++) {
+        for (int x = sink.x; x < sink.x + sink.width; x++) {
+            caught += grid[WeatherCell(x, y)];
+            grid[WeatherCell(x, y)] = 0;
+        }
+    }
+    return caught;
+}
+
+static int Substeps(float speed, float delta) {
+    const int substeps = (int)ceilf(speed * delta);
+    return substeps < 1 ? 1 : (substeps > WEATHER_MAX_SUBSTEPS ? WEATHER_MAX_SUBSTEPS : substeps);
+}
+
+// Explicit diffusion is stable up to a quarter per substep
+static float DiffusionRate(float h) {
+    const float k = WEATHER_DIFFUSION * h;
+    return k > 0.25f ? 0.25f : k;
+}
+
+// Advances grid, which is swapped with the scratch grid every substep
+static float Step(WeatherField *field, float **grid, float speed, int offset, float delta, WeatherRect sink) {
+    const int substeps = Substeps(speed, delta);
+    const float h = delta / substeps;
+    const float c = fminf(speed * h, 1);
+    const float k = DiffusionRate(h);
+    float caught = 0;
+    for (int s = 0; s < substeps; s++) {
+        for (int y = 0; y < WEATHER_HEIGHT; y++) {
+            const int row = WeatherCell(0, y);
+            AdvectRow(field->next, *grid, field->open, row, row + WEATHER_WIDTH, offset, c, k);
+        }
+        float *swap = *grid;
+        *grid = field->next;
+        field->next = swap;
+        caught += Drain(*grid, sink);
+    }
+    return caught;
+}
+
+float WeatherFieldStepWind(WeatherField *field, float delta, WeatherRect sink) {
+    return Step(field, &field->wind, WEATHER_WIND_SPEED, 1, delta, sink);
+}
+
+float WeatherFieldStepRain(WeatherField *field, float delta, WeatherRect sink) {
+    return Step(field, &field->rain, WEATHER_RAIN_SPEED, WEATHER_STRIDE, delta, sink);
+}
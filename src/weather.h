@@ -0,0 +1,69 @@
+#ifndef PIXEL_BLOOM_WEATHER_H
+#define PIXEL_BLOOM_WEATHER_H
+
+// Field weather: wind and rain as two grids the size of the native scene
+// instead of point particles. Wind is the gust power in each cell, blowing
+// right at the mean speed of a wind particle; rain is the water amount in each
+// cell, falling at a fixed speed. Each step is one vectorized stencil over the
+// whole grid: first order upwind advection plus a little diffusion, in
+// conservative form, so what a gust or a drop puts in only leaves the grid
+// through its edges, an obstacle or a sink. Obstacles (the shields) soak up
+// whatever flows into them. A sink (the flower) does too, and reports how
+// much it caught.
+//
+// The cost is fixed by the grid size, however heavy the storm.
+
+#include <stdbool.h>
+
+// Same as NATIVE_WIDTH x NATIVE_HEIGHT, a cell per native pixel
+#define WEATHER_WIDTH 160
+#define WEATHER_HEIGHT 90
+// Every grid has a border cell on each side, always 0: what crosses the edge is gone
+#define WEATHER_STRIDE (WEATHER_WIDTH + 2)
+#define WEATHER_CELLS (WEATHER_STRIDE * (WEATHER_HEIGHT + 2))
+
+// px/s. A substep moves weather at most one cell, so these set how many a
+// tick takes: one at 50Hz
+#define WEATHER_WIND_SPEED 15.0f
+#define WEATHER_RAIN_SPEED 40.0f
+// px^2/s, enough to soften the edges of gusts and drops
+#define WEATHER_DIFFUSION 2.0f
+
+typedef struct WeatherRect {
+    int x;
+    int y;
+    int width;
+    int height;
+} WeatherRect;
+
+typedef struct WeatherField {
+    float *wind;        // gust power
+    float *rain;        // water amount
+    float *next;        // what a step writes, then swapped with the grid it updated
+    float *open;        // 1 where weather moves, 0 inside an obstacle
+    float caughtWater;  // rain the flower caught that isn't a whole drop yet
+} WeatherField;
+
+// Index of cell x, y in any of the grids
+static inline int WeatherCell(int x, int y) {
+    return (y + 1) * WEATHER_STRIDE + x + 1;
+}
+
+// Returns false when out of memory
+bool WeatherFieldInit(WeatherField *field);
+void WeatherFieldFree(WeatherField *field);
+// No wind, no rain and no obstacles
+void WeatherFieldClear(WeatherField *field);
+// Obstacles are set again every tick: clear them, then add one per shield
+void WeatherFieldClearObstacles(WeatherField *field);
+void WeatherFieldAddObstacle(WeatherField *field, float x, float y, float radius);
+// Sources, clipped to the grid: add power or amount to each cell
+void WeatherFieldAddWind(WeatherField *field, WeatherRect rect, float power);
+void WeatherFieldAddRain(WeatherField *field, WeatherRect rect, float amount);
+// Advance one grid by delta seconds, in as many substeps as keep the
+// advection stable. Whatever reaches the sink is taken out of the grid and
+// the total returned
+float WeatherFieldStepWind(WeatherField *field, float delta, WeatherRect sink);
+float WeatherFieldStepRain(WeatherField *field, float delta, WeatherRect sink);
+
+#endif // PIXEL_BLOOM_WEATHER_H
@@ -0,0 +1,84 @@
+// pixel-bloom-asset-pack-check: loads every name=file of a pack written by
+// pixel-bloom-asset-packer through AssetPackLoad and compares it byte for byte
+// with the file it was packed from. Fails unless at least one of them came
+// out of an LZ4 block, so the decoder really runs.
+//
+// usage: pixel-bloom-asset-pack-check PACK.pak name=file ...
+
+#include "asset_pack.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned char *ReadWholeFile(const char *path, long *size) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+    unsigned char *data = NULL;
+    *size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) *size = ftell(file);
+    if (*size >= 0 && fseek(file, 0, SEEK_SET) == 0) data = malloc(*size > 0 ? (size_t)*size : 1);
+    if (data != NULL && fread(data, 1, (size_t)*size, file) != (size_t)*size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+// Returns 1 for an LZ4 asset that matches, 0 for a stored one, -1 on a mismatch
+static int CheckAsset(const AssetPack *pack, const char *spec) {
+    const char *equals = strchr(spec, '=');
+    if (equals == NULL || equals - spec >= ASSET_NAME_SIZE) {
+        fprintf(stderr, "bad asset %s, expected name=file\n", spec);
+        return -1;
+    }
+    char name[ASSET_NAME_SIZE];
+    memcpy(name, spec, equals - spec);
+    name[equals - spec] = '\0';
+
+    long size = 0;
+    unsigned char *expected = ReadWholeFile(equals + 1, &size);
+    if (expected == NULL) {
+        fprintf(stderr, "can't read %s\n", equals + 1);
+        return -1;
+    }
+    AssetBlob blob;
+    int result = -1;
+    if (!AssetPackLoad(pack, name, &blob)) {
+        fprintf(stderr, "%s: not in the pack or corrupt\n", name);
+    } else if (blob.size != size || memcmp(blob.data, expected, (size_t)size) != 0) {
+        fprintf(stderr, "%s: %d bytes loaded don't match the %ld of %s\n", name, blob.size, size, equals + 1);
+    } else {
+        printf("%-24s %8ld bytes %s\n", name, size, blob.owned ? "lz4" : "stored");
+        result = blob.owned ? 1 : 0;
+    }
+    AssetBlobFree(&blob);
+    free(expected);
+    return result;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s PACK.pak name=file ...\n", argv[0]);
+        return 1;
+    }
+    AssetPack pack;
+    if (!AssetPackOpen(&pack, argv[1])) {
+        fprintf(stderr, "can't open %s\n", argv[1]);
+        return 1;
+    }
+    bool ok = true;
+    int decoded = 0;
+    for (int i = 2; i < argc; i++) {
+        const int result = CheckAsset(&pack, argv[i]);
+        if (result < 0) ok = false;
+        if (result > 0) decoded++;
+    }
+    AssetPackClose(&pack);
+    if (decoded == 0) {
+        fprintf(stderr, "no asset was stored as LZ4\n");
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,45 @@
+# Draws a fixed bot session with pixel-bloom-frames and compares every frame byte for byte with the
+# references in GOLDEN_DIR. After a change that's meant to alter the picture, run it once with
+# -DUPDATE=ON to write new references, and look at them before committing.
+#
+# cmake -DFRAMES=<pixel-bloom-frames> -DGOLDEN_DIR=<dir> -DOUTPUT_DIR=<dir> [-DUPDATE=ON] -P golden_frames.cmake
+
+file(REMOVE_RECURSE ${OUTPUT_DIR})
+file(MAKE_DIRECTORY ${OUTPUT_DIR})
+# The weather field goes through the blend, the sprites and particles are drawn either way
+execute_process(
+    COMMAND ${FRAMES} --out ${OUTPUT_DIR} --policy bot --weather field --seed 1 --every 120 --max-seconds 10
+    RESULT_VARIABLE result
+    OUTPUT_QUIET)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "pixel-bloom-frames failed: ${result}")
+endif()
+file(GLOB frames RELATIVE ${OUTPUT_DIR} ${OUTPUT_DIR}/*.ppm)
+
+if (UPDATE)
+    file(GLOB old ${GOLDEN_DIR}/*.ppm)
+    if (old)
+        file(REMOVE ${old})
+    endif()
+    file(COPY ${OUTPUT_DIR}/ DESTINATION ${GOLDEN_DIR} FILES_MATCHING PATTERN "*.ppm")
+    list(LENGTH frames count)
+    message(STATUS "Wrote ${count} golden frames to ${GOLDEN_DIR}")
+    return()
+endif()
+
+file(GLOB golden RELATIVE ${GOLDEN_DIR} ${GOLDEN_DIR}/*.ppm)
+if (NOT frames STREQUAL golden)
+    message(FATAL_ERROR "Frames written: ${frames}\nGolden frames: ${golden}")
+endif()
+set(mismatches "")
+foreach(frame ${frames})
+    execute_process(
+        COMMAND ${CMAKE_COMMAND} -E compare_files ${OUTPUT_DIR}/${frame} ${GOLDEN_DIR}/${frame}
+        RESULT_VARIABLE different)
+    if (different)
+        list(APPEND mismatches ${frame})
+    endif()
+endforeach()
+if (mismatches)
+    message(FATAL_ERROR "Frames that differ from ${GOLDEN_DIR}: ${mismatches}\nThey are in ${OUTPUT_DIR}")
+endif()
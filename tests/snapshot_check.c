@@ -0,0 +1,174 @@
+// pixel-bloom-snapshot-check: records a session into a snapshot ring with a
+// byte budget too small for all of it, then restores every tick still held
+// and compares it with a copy taken while recording. Also checks the budget
+// evicted whole keyframe groups and that SnapshotRingTruncate drops the
+// ticks after the one it's given. Runs a single screen, a weather field and
+// a garden session.
+
+#include "sim.h"
+#include "policy.h"
+#include "snapshot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECK_TICKS 600
+#define CHECK_KEYFRAME_INTERVAL 30
+
+// What a snapshot promises to bring back: the Game without its pointers,
+// the shield grid and the job system, then the live part of every allocation
+static unsigned char *Fingerprint(const Game *game, size_t *size) {
+    const Garden *garden = &game->garden;
+    const bool field = game->weather.wind != NULL;
+    *size = sizeof(Game) + sizeof(float) * 3 * ((size_t)game->wind.count + game->water.count) +
+        (sizeof(float) * 3 + 2) * (size_t)garden->count + (field ? sizeof(float) * 2 * WEATHER_CELLS : 0);
+    unsigned char *bytes = malloc(*size);
+    if (bytes == NULL) return NULL;
+    Game copy;
+    memcpy(&copy, game, sizeof(Game));
+    copy.wind = (ParticleStore){ .count = game->wind.count, .capacity = game->wind.capacity };
+    copy.water = (ParticleStore){ .count = game->water.count, .capacity = game->water.capacity };
+    copy.garden = (Garden){0};
+    copy.grid = (SpatialGrid){0};
+    copy.jobs = NULL;
+    copy.weather = (WeatherField){ .caughtWater = game->weather.caughtWater };
+    unsigned char *out = bytes;
+    memcpy(out, &copy, sizeof(Game));
+    out += sizeof(Game);
+    const ParticleStore *stores[2] = { &game->wind, &game->water };
+    for (int s = 0; s < 2; s++) {
+        const float *lanes[3] = { stores[s]->x, stores[s]->y, stores[s]->value };
+        for (int l = 0; l < 3; l++) {
+            memcpy(out, lanes[l], sizeof(float) * stores[s]->count);
+            out += sizeof(float) * stores[s]->count;
+        }
+    }
+    if (garden->count > 0) {
+        const float *lanes[3] = { garden->waterLevel, garden->health, garden->frameTimer };
+        for (int l = 0; l < 3; l++) {
+            memcpy(out, lanes[l], sizeof(float) * garden->count);
+            out += sizeof(float) * garden->count;
+        }
+        memcpy(out, garden->currentFrame, garden->count);
+        out += garden->count;
+        memcpy(out, garden->isAlive, garden->count);
+        out += garden->count;
+    }
+    if (field) {
+        memcpy(out, game->weather.wind, sizeof(float) * WEATHER_CELLS);
+        memcpy(out + sizeof(float) * WEATHER_CELLS, game->weather.rain, sizeof(float) * WEATHER_CELLS);
+    }
+    return bytes;
+}
+
+static bool Matches(const Game *game, const unsigned char *expected, size_t expectedSize) {
+    size_t size = 0;
+    unsigned char *bytes = Fingerprint(game, &size);
+    const bool matches = bytes != NULL && size == expectedSize && memcmp(bytes, expected, size) == 0;
+    free(bytes);
+    return matches;
+}
+
+// Returns the number of failed checks
+static int CheckSession(const char *name, Game *game, int budgetBytes) {
+    int failures = 0;
+    SimSeed(game, 11);
+    SimReset(game);
+    game->state = StateInGame;
+    const Policy policy = { PolicyCycle, 2 };
+    SnapshotRing *ring = SnapshotRingCreate(CHECK_TICKS, budgetBytes, CHECK_KEYFRAME_INTERVAL);
+    unsigned char *saved[CHECK_TICKS] = {0};
+    size_t savedSize[CHECK_TICKS] = {0};
+    if (ring == NULL) {
+        fprintf(stderr, "%s: out of memory\n", name);
+        return 1;
+    }
+
+    long long recorded = 0;
+    for (; recorded < CHECK_TICKS && game->state == StateInGame; recorded++) {
+        if (!SnapshotRingRecord(ring, game)) {
+            fprintf(stderr, "%s: tick %lld didn't fit the budget\n", name, recorded);
+            failures++;
+            break;
+        }
+        saved[recorded] = Fingerprint(game, &savedSize[recorded]);
+        SimStep(game, PolicyInput(policy, game, recorded, PHYSICS_TIME), PHYSICS_TIME);
+    }
+    const long long oldest = SnapshotRingOldest(ring);
+    const long long newest = SnapshotRingNewest(ring);
+    if (newest != recorded - 1 || oldest <= 0) {
+        fprintf(stderr, "%s: held ticks %lld..%lld of %lld, the budget should have evicted the oldest\n",
+            name, oldest, newest, recorded);
+        failures++;
+    }
+    if (SnapshotRingBytes(ring) > budgetBytes) {
+        fprintf(stderr, "%s: %d bytes over the %d budget\n", name, SnapshotRingBytes(ring), budgetBytes);
+        failures++;
+    }
+
+    // Newest first, so every restore decodes against a different state
+    int wrong = 0;
+    long long firstWrong = -1;
+    for (long long tick = newest; tick >= oldest; tick--) {
+        if (!SnapshotRingRestore(ring, tick, game) || !Matches(game, saved[tick], savedSize[tick])) {
+            wrong++;
+            firstWrong = tick;
+        }
+    }
+    if (wrong > 0) {
+        fprintf(stderr, "%s: %d of %lld ticks didn't restore, the oldest %lld\n", name, wrong, newest - oldest + 1, firstWrong);
+        failures++;
+    }
+    if (oldest > 0 && SnapshotRingRestore(ring, oldest - 1, game)) {
+        fprintf(stderr, "%s: evicted tick %lld still restores\n", name, oldest - 1);
+        failures++;
+    }
+
+    // The ticks after the cut must be gone, and recording goes on from there
+    const long long cut = oldest + (newest - oldest) / 2;
+    SnapshotRingTruncate(ring, cut);
+    if (SnapshotRingNewest(ring) != cut || SnapshotRingRestore(ring, cut + 1, game)) {
+        fprintf(stderr, "%s: ticks after %lld survived the truncate (newest %lld)\n", name, cut, SnapshotRingNewest(ring));
+        failures++;
+    }
+    if (!SnapshotRingRestore(ring, cut, game) || !Matches(game, saved[cut], savedSize[cut])) {
+        fprintf(stderr, "%s: tick %lld didn't restore after the truncate\n", name, cut);
+        failures++;
+    }
+    SimStep(game, PolicyInput(policy, game, cut, PHYSICS_TIME), PHYSICS_TIME);
+    if (!SnapshotRingRecord(ring, game) || SnapshotRingNewest(ring) != cut + 1 ||
+        !SnapshotRingRestore(ring, cut + 1, game) || !Matches(game, saved[cut + 1], savedSize[cut + 1])) {
+        fprintf(stderr, "%s: recording after the truncate didn't continue at tick %lld\n", name, cut + 1);
+        failures++;
+    }
+
+    printf("%-12s ticks %lld..%lld of %lld in %d bytes, %s\n", name, oldest, newest, recorded,
+        SnapshotRingBytes(ring), failures == 0 ? "ok" : "FAILED");
+    for (int i = 0; i < CHECK_TICKS; i++) free(saved[i]);
+    SnapshotRingDestroy(ring);
+    return failures;
+}
+
+int main(void) {
+    int failures = 0;
+    Game *game = calloc(1, sizeof(Game));
+    if (game == NULL) return 1;
+
+    if (!SimInit(game, 2000, 2000)) return 1;
+    failures += CheckSession("particles", game, 12 * 1024);
+    SimFree(game);
+
+    *game = (Game){0};
+    if (!SimInitWeatherField(game)) return 1;
+    failures += CheckSession("field", game, 256 * 1024);
+    SimFree(game);
+
+    *game = (Game){0};
+    if (!SimInitGarden(game, 300)) return 1;
+    failures += CheckSession("garden", game, 2 * 1024 * 1024);
+    SimFree(game);
+
+    free(game);
+    return failures == 0 ? 0 : 1;
+}
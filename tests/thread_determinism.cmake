@@ -0,0 +1,29 @@
+# Plays the same garden session with 1 and with 4 job threads and fails unless both end bit for bit
+# the same: the recorded input logs (the bot reacts to every tick's state, and the log ends with the
+# final score) and everything the runner prints except its timing.
+#
+# cmake -DHEADLESS=<pixel-bloom-headless> -DOUTPUT_DIR=<dir> -P thread_determinism.cmake
+
+file(MAKE_DIRECTORY ${OUTPUT_DIR})
+# Enough flowers that the stores outgrow PARTICLE_JOB_GRAIN and the jobs really split them
+foreach(threads 1 4)
+    execute_process(
+        COMMAND ${HEADLESS} --sessions 1 --garden 20000 --max-seconds 60 --seed 3
+            --threads ${threads} --record ${OUTPUT_DIR}/threads-${threads}.log
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE output)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "pixel-bloom-headless --threads ${threads} failed: ${result}")
+    endif()
+    string(REGEX REPLACE "(threads|wall time|ticks/s|speedup vs 60Hz):[^\n]*\n" "" output${threads} "${output}")
+endforeach()
+
+if (NOT output1 STREQUAL output4)
+    message(FATAL_ERROR "1 thread:\n${output1}\n4 threads:\n${output4}")
+endif()
+execute_process(
+    COMMAND ${CMAKE_COMMAND} -E compare_files ${OUTPUT_DIR}/threads-1.log ${OUTPUT_DIR}/threads-4.log
+    RESULT_VARIABLE different)
+if (different)
+    message(FATAL_ERROR "The input logs of 1 and 4 threads differ, see ${OUTPUT_DIR}")
+endif()
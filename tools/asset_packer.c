@@ -0,0 +1,195 @@
+// pixel-bloom-asset-packer: writes the single-file asset pack the game loads
+// at startup (format in src/asset_pack.h).
+//
+// usage: pixel-bloom-asset-packer OUTPUT.pak name=file ...
+//
+// Each file becomes one LZ4 block, or is stored as is when LZ4 saves less
+// than an eighth of it (already compressed audio, mostly), so it can be used
+// straight from the mapping.
+
+#include "asset_pack.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_ASSETS 256
+
+// LZ4 block rules: matches are at least 4 bytes, the last 5 bytes are always
+// literals and no match starts in the last 12
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MATCH_LIMIT 12
+#define LZ4_MAX_DISTANCE 65535
+#define LZ4_HASH_BITS 16
+
+typedef struct Asset {
+    char name[ASSET_NAME_SIZE];
+    unsigned char *stored;
+    uint32_t storedSize;
+    uint32_t decodedSize;
+    AssetCodec codec;
+    uint32_t offset;
+} Asset;
+
+static unsigned char *ReadWholeFile(const char *path, uint32_t *size) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+    unsigned char *data = NULL;
+    long length = -1;
+    if (fseek(file, 0, SEEK_END) == 0) length = ftell(file);
+    if (length >= 0 && fseek(file, 0, SEEK_SET) == 0) data = malloc(length > 0 ? (size_t)length : 1);
+    if (data != NULL && fread(data, 1, (size_t)length, file) != (size_t)length) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    *size = (uint32_t)length;
+    return data;
+}
+
+static uint32_t Read32(const unsigned char *bytes) {
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static uint32_t Hash(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+static unsigned char *WriteLength(unsigned char *out, int length) {
+    for (; length >= 255; length -= 255) *out++ = 255;
+    *out++ = (unsigned char)length;
+    return out;
+}
+
+static unsigned char *WriteSequence(unsigned char *out, const unsigned char *literals, int literalCount, int distance, int matchLength) {
+    unsigned char *token = out++;
+    *token = (unsigned char)((literalCount >= 15 ? 15 : literalCount) << 4);
+    if (literalCount >= 15) out = WriteLength(out, literalCount - 15);
+    memcpy(out, literals, literalCount);
+    out += literalCount;
+    if (matchLength == 0) return out;
+    *out++ = (unsigned char)(distance & 0xff);
+    *out++ = (unsigned char)(distance >> 8);
+    const int extra = matchLength - LZ4_MIN_MATCH;
+    *token |= (unsigned char)(extra >= 15 ? 15 : extra);
+    if (extra >= 15) out = WriteLength(out, extra - 15);
+    return out;
+}
+
+// Greedy single-probe LZ4 block compressor. Returns the compressed size,
+// out must hold LZ4 worst case: size + size / 255 + 16
+static int Lz4CompressBlock(const unsigned char *source, int size, unsigned char *out) {
+    static int32_t table[1 << LZ4_HASH_BITS];
+    for (int i = 0; i < (1 << LZ4_HASH_BITS); i++) table[i] = -1;
+    unsigned char *start = out;
+    int anchor = 0;
+    int position = 0;
+    while (position + LZ4_MATCH_LIMIT < size) {
+        const uint32_t sequence = Read32(source + position);
+        const uint32_t slot = Hash(sequence);
+        const int candidate = table[slot];
+        table[slot] = position;
+        if (candidate < 0 || position - candidate > LZ4_MAX_DISTANCE || Read32(source + candidate) != sequence) {
+            position++;
+            continue;
+        }
+        int length = LZ4_MIN_MATCH;
+        while (position + length < size - LZ4_LAST_LITERALS && source[candidate + length] == source[position + length]) {
+            length++;
+        }
+        out = WriteSequence(out, source + anchor, position - anchor, position - candidate, length);
+        position += length;
+        anchor = position;
+    }
+    out = WriteSequence(out, source + anchor, size - anchor, 0, 0);
+    return (int)(out - start);
+}
+
+static bool AddAsset(Asset *asset, const char *spec) {
+    const char *equals = strchr(spec, '=');
+    if (equals == NULL || equals == spec || equals - spec >= ASSET_NAME_SIZE) {
+        fprintf(stderr, "bad asset %s, expected name=file with a name under %d characters\n", spec, ASSET_NAME_SIZE);
+        return false;
+    }
+    memset(asset->name, 0, sizeof(asset->name));
+    memcpy(asset->name, spec, equals - spec);
+
+    unsigned char *data = ReadWholeFile(equals + 1, &asset->decodedSize);
+    if (data == NULL) {
+        fprintf(stderr, "can't read %s\n", equals + 1);
+        return false;
+    }
+    unsigned char *compressed = malloc(asset->decodedSize + asset->decodedSize / 255 + 16);
+    if (compressed == NULL) return false;
+    const int compressedSize = Lz4CompressBlock(data, (int)asset->decodedSize, compressed);
+    if ((uint32_t)compressedSize < asset->decodedSize - asset->decodedSize / 8) {
+        asset->stored = compressed;
+        asset->storedSize = (uint32_t)compressedSize;
+        asset->codec = AssetCodecLz4;
+        free(data);
+    } else {
+        asset->stored = data;
+        asset->storedSize = asset->decodedSize;
+        asset->codec = AssetCodecStored;
+        free(compressed);
+    }
+    return true;
+}
+
+static void Write32(FILE *file, uint32_t value) {
+    const unsigned char bytes[4] = { value & 0xff, (value >> 8) & 0xff, (value >> 16) & 0xff, value >> 24 };
+    fwrite(bytes, 1, 4, file);
+}
+
+static void Pad(FILE *file, long to) {
+    while (ftell(file) < to) fputc(0, file);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc - 2 > MAX_ASSETS) {
+        fprintf(stderr, "usage: %s OUTPUT.pak name=file ... (up to %d files)\n", argv[0], MAX_ASSETS);
+        return 1;
+    }
+    static Asset assets[MAX_ASSETS];
+    const int count = argc - 2;
+    uint32_t offset = ASSET_HEADER_SIZE + count * ASSET_ENTRY_SIZE;
+    for (int i = 0; i < count; i++) {
+        if (!AddAsset(&assets[i], argv[i + 2])) return 1;
+        offset = (offset + ASSET_ALIGNMENT - 1) & ~(uint32_t)(ASSET_ALIGNMENT - 1);
+        assets[i].offset = offset;
+        offset += assets[i].storedSize;
+    }
+
+    FILE *file = fopen(argv[1], "wb");
+    if (file == NULL) {
+        fprintf(stderr, "can't write %s\n", argv[1]);
+        return 1;
+    }
+    fwrite("PBPK", 1, 4, file);
+    Write32(file, ASSET_PACK_VERSION);
+    Write32(file, (uint32_t)count);
+    Write32(file, 0);
+    for (int i = 0; i < count; i++) {
+        fwrite(assets[i].name, 1, ASSET_NAME_SIZE, file);
+        Write32(file, assets[i].offset);
+        Write32(file, assets[i].storedSize);
+        Write32(file, assets[i].decodedSize);
+        Write32(file, assets[i].codec);
+    }
+    for (int i = 0; i < count; i++) {
+        Pad(file, (long)assets[i].offset);
+        fwrite(assets[i].stored, 1, assets[i].storedSize, file);
+        printf("%-*s %10u -> %10u %s\n", ASSET_NAME_SIZE, assets[i].name, assets[i].decodedSize, assets[i].storedSize,
+            assets[i].codec == AssetCodecLz4 ? "lz4" : "stored");
+    }
+    const bool ok = ferror(file) == 0;
+    if (fclose(file) != 0 || !ok) {
+        fprintf(stderr, "can't write %s\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,256 @@
+// pixel-bloom-atlas-packer: packs sprite sheets into one RGBA atlas and writes
+// it as a C header with the raw pixels and a frame table, so the game neither
+// reads nor decodes any PNG at startup.
+//
+// usage: pixel-bloom-atlas-packer OUTPUT.h name:frames:sheet.png ...
+//
+// Every sheet is a row of frames of the same width. Each name becomes a
+// Sprite<Name> entry of atlasSprites (see src/sprite_sheet.h), and a 3x3 white block
+// is always added as SpriteWhite for shapes drawn through the atlas.
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#include "stb_image.h"
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SHEETS 32
+#define MAX_FRAMES 1024
+#define ATLAS_PADDING 1     // keeps neighbour frames from bleeding in
+#define WHITE_SIZE 3        // shapes sample the center pixel only
+#define MAX_ATLAS_SIZE 4096
+
+typedef struct Sheet {
+    char name[64];
+    int frameCount;
+    int width;
+    int height;
+    unsigned char *pixels;
+} Sheet;
+
+typedef struct Frame {
+    int sheet;
+    int index;          // frame within the sheet
+    int width;
+    int height;
+    int x;              // position in the atlas
+    int y;
+} Frame;
+
+static Sheet sheets[MAX_SHEETS];
+static int sheetCount = 0;
+static Frame frames[MAX_FRAMES];
+static int frameCount = 0;
+
+static bool AddSheet(const char *spec) {
+    const char *firstColon = strchr(spec, ':');
+    const char *secondColon = firstColon != NULL ? strchr(firstColon + 1, ':') : NULL;
+    if (secondColon == NULL || firstColon == spec || firstColon - spec >= (int)sizeof(sheets[0].name)) {
+        fprintf(stderr, "bad sheet %s, expected name:frames:file.png\n", spec);
+        return false;
+    }
+    if (sheetCount >= MAX_SHEETS) {
+        fprintf(stderr, "more than %d sheets\n", MAX_SHEETS);
+        return false;
+    }
+    Sheet *sheet = &sheets[sheetCount];
+    memcpy(sheet->name, spec, firstColon - spec);
+    sheet->name[firstColon - spec] = '\0';
+    sheet->frameCount = atoi(firstColon + 1);
+
+    int channels = 0;
+    sheet->pixels = stbi_load(secondColon + 1, &sheet->width, &sheet->height, &channels, 4);
+    if (sheet->pixels == NULL) {
+        fprintf(stderr, "can't load %s: %s\n", secondColon + 1, stbi_failure_reason());
+        return false;
+    }
+    if (sheet->frameCount <= 0 || sheet->width % sheet->frameCount != 0) {
+        fprintf(stderr, "%s is %d wide, not a row of %d frames\n", secondColon + 1, sheet->width, sheet->frameCount);
+        free(sheet->pixels);
+        return false;
+    }
+    sheetCount++;
+    return true;
+}
+
+static bool AddWhiteSheet(void) {
+    if (sheetCount >= MAX_SHEETS) {
+        fprintf(stderr, "more than %d sheets with the white block\n", MAX_SHEETS - 1);
+        return false;
+    }
+    Sheet *sheet = &sheets[sheetCount];
+    snprintf(sheet->name, sizeof(sheet->name), "white");
+    sheet->frameCount = 1;
+    sheet->width = WHITE_SIZE;
+    sheet->height = WHITE_SIZE;
+    sheet->pixels = malloc(WHITE_SIZE * WHITE_SIZE * 4);
+    if (sheet->pixels == NULL) return false;
+    memset(sheet->pixels, 0xff, WHITE_SIZE * WHITE_SIZE * 4);
+    sheetCount++;
+    return true;
+}
+
+// Tallest first, then in command line order, so the layout is reproducible
+static int CompareFrames(const void *a, const void *b) {
+    const Frame *left = a;
+    const Frame *right = b;
+    if (left->height != right->height) return right->height - left->height;
+    if (left->sheet != right->sheet) return left->sheet - right->sheet;
+    return left->index - right->index;
+}
+
+static int NextPowerOfTwo(int value) {
+    int power = 1;
+    while (power < value) power *= 2;
+    return power;
+}
+
+// Shelf packing at a fixed width, returns the height used or -1 if a frame
+// doesn't fit
+static int PackShelves(int width, bool place) {
+    int x = 0;
+    int y = 0;
+    int shelfHeight = 0;
+    for (int i = 0; i < frameCount; i++) {
+        Frame *frame = &frames[i];
+        if (frame->width + ATLAS_PADDING > width) return -1;
+        if (x + frame->width + ATLAS_PADDING > width) {
+            y += shelfHeight;
+            x = 0;
+            shelfHeight = 0;
+        }
+        if (place) {
+            frame->x = x;
+            frame->y = y;
+        }
+        x += frame->width + ATLAS_PADDING;
+        if (frame->height + ATLAS_PADDING > shelfHeight) shelfHeight = frame->height + ATLAS_PADDING;
+    }
+    return y + shelfHeight;
+}
+
+static bool WriteHeader(const char *path, int width, int height, const unsigned char *pixels) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "can't write %s\n", path);
+        return false;
+    }
+    fprintf(file, "// Generated by tools/atlas_packer.c, do not edit\n\n");
+    fprintf(file, "#define ATLAS_WIDTH %d\n#define ATLAS_HEIGHT %d\n#define ATLAS_FRAME_COUNT %d\n\n", width, height, frameCount);
+    for (int s = 0; s < sheetCount; s++) {
+        fprintf(file, "#define ATLAS_");
+        for (const char *c = sheets[s].name; *c != '\0'; c++) fputc(toupper((unsigned char)*c), file);
+        fprintf(file, "_FRAMES %d\n", sheets[s].frameCount);
+    }
+    fprintf(file, "\n");
+
+    // Frames listed sheet by sheet, so each sprite is a contiguous run
+    fprintf(file, "static const SpriteRect atlasFrames[ATLAS_FRAME_COUNT] = {\n");
+    int first[MAX_SHEETS] = {0};
+    int written = 0;
+    for (int s = 0; s < sheetCount; s++) {
+        first[s] = written;
+        for (int index = 0; index < sheets[s].frameCount; index++) {
+            for (int i = 0; i < frameCount; i++) {
+                if (frames[i].sheet != s || frames[i].index != index) continue;
+                fprintf(file, "    { %d, %d, %d, %d }, // %s %d\n", frames[i].x, frames[i].y, frames[i].width, frames[i].height, sheets[s].name, index);
+            }
+            written++;
+        }
+    }
+    fprintf(file, "};\n\n");
+
+    fprintf(file, "static const AtlasSprite atlasSprites[SpriteCount] = {\n");
+    for (int s = 0; s < sheetCount; s++) {
+        const char *name = sheets[s].name;
+        fprintf(file, "    [Sprite%c%s] = { %d, %d },\n", toupper((unsigned char)name[0]), name + 1, first[s], sheets[s].frameCount);
+    }
+    fprintf(file, "};\n\n");
+
+    fprintf(file, "static const unsigned char atlasPixels[ATLAS_WIDTH*ATLAS_HEIGHT*4] = {\n");
+    const int bytes = width * height * 4;
+    for (int i = 0; i < bytes; i++) {
+        fprintf(file, "%d,%s", pixels[i], (i % 32 == 31) ? "\n" : "");
+    }
+    fprintf(file, "\n};\n");
+    const bool ok = ferror(file) == 0;
+    return fclose(file) == 0 && ok;
+}
+
+static void FreeSheets(void) {
+    // stb_image allocates with plain malloc too (STBI_MALLOC isn't overridden)
+    for (int s = 0; s < sheetCount; s++) {
+        free(sheets[s].pixels);
+    }
+    sheetCount = 0;
+}
+
+static bool Pack(const char *outputPath) {
+    for (int s = 0; s < sheetCount; s++) {
+        for (int index = 0; index < sheets[s].frameCount; index++) {
+            if (frameCount >= MAX_FRAMES) {
+                fprintf(stderr, "more than %d frames\n", MAX_FRAMES);
+                return false;
+            }
+            frames[frameCount++] = (Frame){ s, index, sheets[s].width / sheets[s].frameCount, sheets[s].height, 0, 0 };
+        }
+    }
+    qsort(frames, frameCount, sizeof(Frame), CompareFrames);
+
+    // Smallest power of two area wins, the squarer one on a tie
+    int bestWidth = 0;
+    int bestHeight = 0;
+    for (int width = 16; width <= MAX_ATLAS_SIZE; width *= 2) {
+        const int used = PackShelves(width, false);
+        if (used < 0) continue;
+        const int height = NextPowerOfTwo(used);
+        if (height > MAX_ATLAS_SIZE) continue;
+        const int longest = width > height ? width : height;
+        const int bestLongest = bestWidth > bestHeight ? bestWidth : bestHeight;
+        if (bestWidth == 0 || width * height < bestWidth * bestHeight ||
+            (width * height == bestWidth * bestHeight && longest < bestLongest)) {
+            bestWidth = width;
+            bestHeight = height;
+        }
+    }
+    if (bestWidth == 0) {
+        fprintf(stderr, "sprites don't fit a %dx%d atlas\n", MAX_ATLAS_SIZE, MAX_ATLAS_SIZE);
+        return false;
+    }
+    PackShelves(bestWidth, true);
+
+    unsigned char *pixels = calloc((size_t)bestWidth * bestHeight, 4);
+    if (pixels == NULL) return false;
+    for (int i = 0; i < frameCount; i++) {
+        const Frame *frame = &frames[i];
+        const Sheet *sheet = &sheets[frame->sheet];
+        for (int row = 0; row < frame->height; row++) {
+            const unsigned char *source = sheet->pixels + ((size_t)row * sheet->width + frame->index * frame->width) * 4;
+            unsigned char *destination = pixels + ((size_t)(frame->y + row) * bestWidth + frame->x) * 4;
+            memcpy(destination, source, (size_t)frame->width * 4);
+        }
+    }
+    const bool written = WriteHeader(outputPath, bestWidth, bestHeight, pixels);
+    free(pixels);
+    if (!written) return false;
+    printf("atlas %dx%d, %d frames from %d sheets\n", bestWidth, bestHeight, frameCount, sheetCount);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s OUTPUT.h name:frames:sheet.png ...\n", argv[0]);
+        return 1;
+    }
+    bool ok = true;
+    for (int i = 2; i < argc && ok; i++) {
+        ok = AddSheet(argv[i]);
+    }
+    ok = ok && AddWhiteSheet() && Pack(argv[1]);
+    FreeSheets();
+    return ok ? 0 : 1;
+}